@@ -1,153 +1,1664 @@
 /* Chud_Pi.cc
-   Computing pi by Binary Splitting Algorithm with GMP libarary.
-   clang++ -o chud_pi Chud_Pi.cc -lgmpxx -lgmp -std=c++11 -O3
+   Computing pi (and other constants) by Binary Splitting Algorithm with
+   GMP libarary.
+   clang++ -o chud_pi Chud_Pi.cc -lgmpxx -lgmp -std=c++11 -O3 -pthread
 */
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
-#include <iostream>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
 #include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <gmpxx.h>
 
 using namespace std;
 
-const string MSG_USAGE = "Usage:\nchud_pi n <file>\n\nwhere <file> is one of:\n\t- A legal file name for saving pi value or\n\t- BLANK, will just compute without saving.\n\nThe n is an integer number specifying the pi digits to compute\n\nExample:\nchud_pi 1024 Pi.txt\n";
+const string MSG_USAGE = "Usage:\nchud_pi [options] n <file>\n\nwhere <file> is one of:\n\t- A legal file name for saving the value or\n\t- BLANK, will just compute without saving.\n\nThe n is an integer number specifying the digits to compute\n\nOptions:\n\t-c, --const <name>\tConstant: pi (default), e, ln2, sqrt2, zeta3, catalan\n\t-t, --threads <k>\tNumber of worker threads (default: 1)\n\t-l, --lean\t\tMemory-lean evaluation (in-place merges, early frees)\n\t-d, --direct\t\tWrite the digits with O_DIRECT (bypass page cache)\n\t-k, --checkpoint <dir>\tSave finished subtrees to <dir> in the background\n\t-r, --resume\t\tReload finished subtrees from the checkpoint <dir>\n\t-s, --swap <dir>\tKeep big integers in memory-mapped files under <dir>\n\t-v, --verify[=d,...]\tCheck the hex digits after the first d by BBP\n\t\t\t\t(default: the last position)\n\t-j, --stats <file>\tWrite per-phase time, memory and multiplications as JSON\n\nExample:\nchud_pi -t 8 1024 Pi.txt\n";
+
+const int PAR_MIN_TERMS = 2048;        // Subtrees smaller than this stay serial
+const mp_size_t PAR_MUL_LIMBS = 8192;  // Products smaller than this use mpz_mul
+const long WRITE_BLOCK = 1 << 20;      // Bytes of output per digit block
+const int CKPT_MIN_TERMS = 1 << 16;    // Subtrees checkpointed (~930K digits)
+const size_t SWAP_MIN_BYTES = 1 << 24; // Blocks this big go to the swap files
+const long NEWTON_MIN_BITS = 4096;     // Newton iterations start from a division
+const long NEWTON_GUARD = 32;          // Extra bits carried per Newton step
+const long FINISH_GUARD = 64;          // Extra bits of the fixed-point finish
+const int VERIFY_BITS = 24;            // Leading bits that must match (6 hex)
+const int STAT_BUCKETS = 48;           // Multiplications by log2(limbs)
+const int STAT_DEPTHS = 64;            // Split tree depths tracked
 
 char *FILENAME;
 unsigned int DIGITS;
+unsigned int THREADS = 1;
+bool LEAN = false;
+bool DIRECT_IO = false;
+string CKPT_DIR;
+bool RESUME = false;
+string SWAP_DIR;
+string CONSTANT = "pi";
+bool VERIFY = false;
+vector<long> VERIFY_POS;
+string STATS_FILE;
 
 struct PQT
 {
     mpz_class P, Q, T;
 };
 
-class Chudnovsky
+/*
+ * Give the limbs of x back to the allocator (assigning 0 keeps them).
+ */
+inline void release(mpz_class &x)
+{
+    mpz_class().swap(x);
+}
+
+/*
+ * Peak resident set size of this process, in MB.
+ */
+double peakRSS()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1048576.0; // bytes
+#else
+    return ru.ru_maxrss / 1024.0;    // KB
+#endif
+}
+
+/*
+ * Instrumentation (--stats)
+ * Phases run one after the other; each gets its wall time, process CPU
+ * time, peak RSS so far and the big multiplications done in it, counted by
+ * log2 of the larger operand's limbs. The merges of the split tree are
+ * also broken down by depth: their count, time summed over the merges
+ * (which may overlap on different threads), and products by size.
+ * Everything is written as one JSON object at the end of the run; with
+ * no --stats the hooks cost a branch.
+ */
+class Stats
+{
+public:
+    struct Counter
+    {
+        atomic<uint64_t> muls[STAT_BUCKETS];
+        atomic<uint64_t> merges;
+        atomic<int64_t> wallNs, cpuNs;
+        Counter();
+        void mul(mp_size_t limbs);
+    };
+
+    /*
+     * Times one merge of the split tree and counts its products.
+     */
+    class Merge
+    {
+        int depth, n;
+        mp_size_t limbs[4];
+        chrono::steady_clock::time_point wall;
+        int64_t cpu;
+
+    public:
+        Merge(int depth, const PQT &res1, const PQT &res2, bool needP);
+        void done();
+    };
+
+    bool enabled;
+    Stats() : enabled(false), current(NULL) {}
+    void begin(const string &name); // Ends the running phase, if any
+    void end();
+    void note(const string &key, double value); // Extra field of the phase
+    void mul(const mpz_class &a, const mpz_class &b);
+    void save(const string &file, const string &constant, long terms);
+
+private:
+    struct Phase
+    {
+        string name;
+        double wall, cpu, rss;
+        Counter c;
+        vector<pair<string, double>> notes;
+    };
+    deque<Phase> phases;
+    Phase *current;
+    Counter depths[STAT_DEPTHS];
+    chrono::steady_clock::time_point wall0;
+    double cpu0;
+    static double cpuSeconds();
+    static int64_t threadCpuNs();
+    static void json(ostream &os, const Counter &c);
+};
+
+Stats STATS;
+
+Stats::Counter::Counter() : merges(0), wallNs(0), cpuNs(0)
+{
+    for (int i = 0; i < STAT_BUCKETS; i++)
+        muls[i] = 0;
+}
+
+void Stats::Counter::mul(mp_size_t limbs)
+{
+    int b = 0;
+    while (b < STAT_BUCKETS - 1 && (mp_size_t(2) << b) <= limbs)
+        b++;
+    muls[b]++;
+}
+
+double Stats::cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+int64_t Stats::threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void Stats::begin(const string &name)
+{
+    if (!enabled)
+        return;
+    end();
+    phases.emplace_back();
+    current = &phases.back();
+    current->name = name;
+    wall0 = chrono::steady_clock::now();
+    cpu0 = cpuSeconds();
+}
+
+void Stats::end()
+{
+    if (!enabled || current == NULL)
+        return;
+    current->wall = chrono::duration<double>(chrono::steady_clock::now() - wall0).count();
+    current->cpu = cpuSeconds() - cpu0;
+    current->rss = peakRSS();
+    current = NULL;
+}
+
+void Stats::note(const string &key, double value)
+{
+    if (enabled && current != NULL)
+        current->notes.push_back(make_pair(key, value));
+}
+
+void Stats::mul(const mpz_class &a, const mpz_class &b)
+{
+    if (enabled && current != NULL)
+        current->c.mul(max(mpz_size(a.get_mpz_t()), mpz_size(b.get_mpz_t())));
+}
+
+Stats::Merge::Merge(int depth, const PQT &res1, const PQT &res2, bool needP)
+    : depth(min(depth, STAT_DEPTHS - 1)), n(0)
+{
+    if (!STATS.enabled)
+        return;
+    const mpz_class *ops[4][2] = {{&res1.Q, &res2.Q}, {&res1.T, &res2.Q},
+                                  {&res1.P, &res2.T}, {&res1.P, &res2.P}};
+    for (n = 0; n < (needP ? 4 : 3); n++)
+        limbs[n] = max(mpz_size(ops[n][0]->get_mpz_t()), mpz_size(ops[n][1]->get_mpz_t()));
+    wall = chrono::steady_clock::now();
+    cpu = threadCpuNs();
+}
+
+void Stats::Merge::done()
+{
+    if (!STATS.enabled)
+        return;
+    Counter &c = STATS.depths[depth];
+    c.wallNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - wall).count();
+    c.cpuNs += threadCpuNs() - cpu;
+    c.merges++;
+    for (int i = 0; i < n; i++)
+        c.mul(limbs[i]);
+}
+
+void Stats::json(ostream &os, const Counter &c)
+{
+    os << "{";
+    bool first = true;
+    for (int i = 0; i < STAT_BUCKETS; i++)
+        if (c.muls[i] != 0)
+        {
+            os << (first ? "" : ", ") << "\"2^" << i << "\": " << c.muls[i];
+            first = false;
+        }
+    os << "}";
+}
+
+void Stats::save(const string &file, const string &constant, long terms)
+{
+    end();
+    ofstream os(file);
+    os << setprecision(6) << fixed;
+    os << "{\n  \"constant\": \"" << constant << "\", \"digits\": " << DIGITS
+       << ", \"terms\": " << terms << ", \"threads\": " << THREADS << ",\n"
+       << "  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        const Phase &ph = phases[i];
+        os << (i ? "," : "") << "\n    {\"name\": \"" << ph.name << "\", \"wall\": "
+           << ph.wall << ", \"cpu\": " << ph.cpu << ", \"peak_rss_mb\": " << ph.rss;
+        for (auto &nt : ph.notes)
+            os << ", \"" << nt.first << "\": " << nt.second;
+        os << ", \"muls\": ";
+        json(os, ph.c);
+        os << "}";
+    }
+    os << "\n  ],\n  \"merge_depths\": [";
+    bool first = true;
+    for (int d = 0; d < STAT_DEPTHS; d++)
+    {
+        const Counter &c = depths[d];
+        if (c.merges == 0)
+            continue;
+        os << (first ? "" : ",") << "\n    {\"depth\": " << d << ", \"merges\": " << c.merges
+           << ", \"wall\": " << c.wallNs / 1e9 << ", \"cpu\": " << c.cpuNs / 1e9
+           << ", \"muls\": ";
+        json(os, c);
+        os << "}";
+        first = false;
+    }
+    os << "\n  ]\n}\n";
+    if (!os)
+        throw runtime_error("cannot write " + file);
+}
+
+/*
+ * Multiply r = |a| * |b| on up to `threads` threads (Karatsuba on top of
+ * mpz limbs). Splits at half the limbs of the larger operand,
+ * x = x1 * 2^k + x0, and runs x0*y0, x1*y1 and (x0+x1)*(y0+y1) side by
+ * side, each with a third of the threads. If the smaller operand fits below
+ * the split, it is simply multiplied against both halves of the larger one.
+ * The halves are read-only views on the operands' limbs, nothing is copied.
+ */
+void parMulAbs(mpz_ptr r, mpz_srcptr a, mpz_srcptr b, int threads)
+{
+    mp_size_t na = mpz_size(a), nb = mpz_size(b);
+    if (threads < 2 || min(na, nb) < PAR_MUL_LIMBS)
+    {
+        mpz_mul(r, a, b);
+        mpz_abs(r, r);
+        return;
+    }
+    mpz_srcptr x = na >= nb ? a : b; // Larger operand
+    mpz_srcptr y = na >= nb ? b : a; // Smaller operand
+    mp_size_t nx = max(na, nb), ny = min(na, nb), k = nx / 2;
+    const mp_limb_t *xp = mpz_limbs_read(x), *yp = mpz_limbs_read(y);
+    int sub = max(1, threads / 3);
+
+    mpz_t x0, x1, y0, y1;
+    mpz_roinit_n(x0, xp, k);
+    mpz_roinit_n(x1, xp + k, nx - k);
+    mpz_class z0, z1, z2;
+    if (ny <= k)
+    {
+        // r = (x1 * y) << k + x0 * y
+        mpz_roinit_n(y0, yp, ny);
+        thread th([&] { parMulAbs(z0.get_mpz_t(), x0, y0, threads / 2); });
+        parMulAbs(z2.get_mpz_t(), x1, y0, threads - threads / 2);
+        th.join();
+        mpz_mul_2exp(r, z2.get_mpz_t(), k * GMP_NUMB_BITS);
+        mpz_add(r, r, z0.get_mpz_t());
+        return;
+    }
+
+    mpz_roinit_n(y0, yp, k);
+    mpz_roinit_n(y1, yp + k, ny - k);
+    mpz_class xs, ys;
+    mpz_add(xs.get_mpz_t(), x0, x1);
+    mpz_add(ys.get_mpz_t(), y0, y1);
+    thread th0([&] { parMulAbs(z0.get_mpz_t(), x0, y0, sub); });
+    thread th2([&] { parMulAbs(z2.get_mpz_t(), x1, y1, sub); });
+    parMulAbs(z1.get_mpz_t(), xs.get_mpz_t(), ys.get_mpz_t(),
+              max(1, threads - 2 * sub));
+    th0.join();
+    th2.join();
+
+    // r = z2 << 2k + (z1 - z0 - z2) << k + z0
+    z1 -= z0;
+    z1 -= z2;
+    mpz_mul_2exp(r, z2.get_mpz_t(), k * GMP_NUMB_BITS);
+    mpz_add(r, r, z1.get_mpz_t());
+    mpz_mul_2exp(r, r, k * GMP_NUMB_BITS);
+    mpz_add(r, r, z0.get_mpz_t());
+}
+
+/*
+ * Multiply r = a * b, multi-threaded above PAR_MUL_LIMBS.
+ */
+void parMul(mpz_class &r, const mpz_class &a, const mpz_class &b, int threads)
+{
+    STATS.mul(a, b);
+    int sign = sgn(a) * sgn(b);
+    parMulAbs(r.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t(), threads);
+    if (sign < 0)
+        mpz_neg(r.get_mpz_t(), r.get_mpz_t());
+}
+
+/*
+ * Fixed-point reciprocal by Newton iteration
+ * For x of m bits (read as x / 2^m in [1/2, 1)), returns r ~= 2^(2m) / x.
+ * Each step solves for about half the bits and doubles them with
+ * r = r0 + r0 * (1 - x * r0), so the whole cost is a few multiplications.
+ */
+void fixRecip(mpz_class &r, const mpz_class &x, long m, int threads)
+{
+    if (m <= NEWTON_MIN_BITS)
+    {
+        mpz_class one = 1;
+        one <<= 2 * m;
+        r = one / x;
+        return;
+    }
+    long h = m / 2 + NEWTON_GUARD;
+    mpz_class rh, e;
+    fixRecip(rh, x >> (m - h), h, threads);
+
+    // e = 2^(m+h) - x * rh, then r = rh << (m-h) + rh * e >> 2h; e is only
+    // about m bits long and h of them are enough
+    parMul(e, x, rh, threads);
+    e = (mpz_class(1) << (m + h)) - e;
+    e >>= m - h;
+    parMul(e, rh, e, threads);
+    r = (rh << (m - h)) + (e >> (3 * h - m));
+}
+
+/*
+ * Fixed-point division by Newton iteration (Karp-Markstein)
+ * For num and den of m bits, returns u ~= 2^m * num / den. The reciprocal
+ * only goes to half precision; the last Newton step is folded into the
+ * multiplication by num, which saves a full-size product.
+ */
+void fixDiv(mpz_class &u, const mpz_class &num, const mpz_class &den, long m,
+            int threads)
+{
+    if (m <= NEWTON_MIN_BITS)
+    {
+        u = (num << m) / den;
+        return;
+    }
+    long h = m / 2 + NEWTON_GUARD;
+    mpz_class rh, u0, e;
+    fixRecip(rh, den >> (m - h), h, threads);
+
+    // u0 = num * rh at h bits, e = num - den * u0, u = u0 + rh * e
+    parMul(u0, num >> (m - h), rh, threads);
+    u0 >>= h;
+    parMul(e, den, u0, threads);
+    e = (num << h) - e;
+    e >>= m - h;
+    parMul(e, rh, e, threads);
+    u = (u0 << (m - h)) + (e >> (3 * h - m));
+}
+
+/*
+ * Fixed-point inverse square root by Newton iteration
+ * Returns s ~= 2^m / sqrt(E) for a small integer E, with
+ * s = s0 + s0 * (1 - E * s0^2) / 2.
+ */
+void fixInvSqrt(mpz_class &s, unsigned long E, long m, int threads)
+{
+    if (m <= NEWTON_MIN_BITS)
+    {
+        mpz_class one = 1;
+        one <<= 2 * m;
+        s = sqrt(one / E);
+        return;
+    }
+    long h = m / 2 + NEWTON_GUARD;
+    mpz_class sh, e;
+    fixInvSqrt(sh, E, h, threads);
+
+    // e = 2^2h - E * sh^2, then s = sh << (m-h) + sh * e >> (3h+1-m)
+    parMul(e, sh, sh, threads);
+    e *= E;
+    e = (mpz_class(1) << (2 * h)) - e;
+    parMul(e, sh, e, threads);
+    s = (sh << (m - h)) + (e >> (3 * h + 1 - m));
+}
+
+/*
+ * The top m bits of x (shifted up if x is shorter).
+ */
+mpz_class topBits(const mpz_class &x, long m)
+{
+    long n = mpz_sizeinbase(x.get_mpz_t(), 2);
+    return n >= m ? mpz_class(x >> (n - m)) : mpz_class(x << (m - n));
+}
+
+/*
+ * num / den = u / 2^W * 2^scale, with u of about W bits, by Newton division
+ * on the top W bits of both (which frees the full-size ones).
+ */
+mpz_class fixQuotient(mpz_class &num, mpz_class &den, long W, long &scale)
+{
+    scale = (long)mpz_sizeinbase(num.get_mpz_t(), 2) -
+            (long)mpz_sizeinbase(den.get_mpz_t(), 2);
+    mpz_class a = topBits(num, W), b = topBits(den, W), u;
+    release(num);
+    release(den);
+    fixDiv(u, a, b, W, THREADS);
+    return u;
+}
+
+/*
+ * c1 / c2 * X / Q * 2^W, for small integers c1 and c2.
+ */
+mpz_class fixValue(mpz_class &X, mpz_class &Q, long W, unsigned long c1,
+                   unsigned long c2)
+{
+    long scale;
+    mpz_class u = fixQuotient(X, Q, W, scale);
+    u *= c1;
+    u /= c2;
+    return scale >= 0 ? mpz_class(u << scale) : mpz_class(u >> -scale);
+}
+
+/*
+ * BBP spot check
+ * frac(16^d * pi) as a 32-bit fraction, straight from the Bailey-Borwein-
+ * Plouffe formula pi = sum 16^-k (4/(8k+1) - 2/(8k+4) - 1/(8k+5) - 1/(8k+6)).
+ * That is the hex digits d+1, d+2, ... of pi, at O(d log d) cost and
+ * without any big numbers.
+ */
+uint64_t powMod16(uint64_t e, uint64_t m)
+{
+    if (m < (1ULL << 32)) // Products fit in 64 bits
+    {
+        // x * y mod m with no division (Barrett): mu = 2^64 / m gives a
+        // quotient at most one short, and one subtraction fixes it up
+        uint64_t mu = ~0ULL / m;
+        auto mulMod = [m, mu](uint64_t x, uint64_t y) {
+            uint64_t xy = x * y;
+            uint64_t r = xy - (uint64_t)(((unsigned __int128)xy * mu) >> 64) * m;
+            return r >= m ? r - m : r;
+        };
+        // 16^e = 2^(4e), left to right: a set bit of 4e costs a doubling
+        // (shift and subtract) instead of a product
+        uint64_t r = 1 % m, f = 4 * e;
+        for (int i = 63 - (f ? __builtin_clzll(f) : 63); i >= 0; i--)
+        {
+            r = mulMod(r, r);
+            if (f >> i & 1)
+            {
+                r <<= 1;
+                r = r >= m ? r - m : r;
+            }
+        }
+        return r;
+    }
+    unsigned __int128 r = 1 % m, b = 16 % m;
+    for (; e > 0; e >>= 1)
+    {
+        if (e & 1)
+            r = r * b % m;
+        b = b * b % m;
+    }
+    return (uint64_t)r;
+}
+
+/*
+ * 16^e[i] mod m[i] for BBP_LANES independent (e, m) pairs at once. The
+ * squaring chains do not depend on each other, so interleaving them hides
+ * the multiply latency that a single chain waits on.
+ */
+const int BBP_LANES = 8; // Two k, four series each
+
+void powMod16xN(const uint64_t e[BBP_LANES], const uint64_t m[BBP_LANES], uint64_t r[BBP_LANES])
+{
+    uint64_t mu[BBP_LANES], f[BBP_LANES], top = 0;
+    for (int i = 0; i < BBP_LANES; i++)
+    {
+        if (m[i] >= (1ULL << 32))
+        {
+            for (int j = 0; j < BBP_LANES; j++)
+                r[j] = powMod16(e[j], m[j]);
+            return;
+        }
+        mu[i] = ~0ULL / m[i];
+        r[i] = 1 % m[i];
+        f[i] = 4 * e[i];
+        top |= f[i];
+    }
+    // Lanes with a shorter exponent square 1 until their top bit
+    for (int b = 63 - (top ? __builtin_clzll(top) : 63); b >= 0; b--)
+        for (int i = 0; i < BBP_LANES; i++)
+        {
+            uint64_t xy = r[i] * r[i];
+            uint64_t t = xy - (uint64_t)(((unsigned __int128)xy * mu[i]) >> 64) * m[i];
+            t = t >= m[i] ? t - m[i] : t;
+            t <<= f[i] >> b & 1;
+            r[i] = t >= m[i] ? t - m[i] : t;
+        }
+}
+
+/*
+ * Add frac(sum_k 16^(d-k) / (8k+j)) over k in [k0, k1) to s[0..3], for
+ * j = 1, 4, 5, 6; the terms k <= d are taken mod 8k+j. The tail k > d is
+ * added by the chunk whose range ends past d.
+ */
+const int BBP_J[4] = {1, 4, 5, 6};
+
+void bbpSeries(uint64_t d, uint64_t k0, uint64_t k1, long double s[4])
+{
+    uint64_t e[BBP_LANES], m[BBP_LANES], r[BBP_LANES];
+    k1 = min(k1, d + 1);
+    for (uint64_t k = k0; k < k1; k += BBP_LANES / 4)
+    {
+        for (int i = 0; i < BBP_LANES; i++) // Past k1: 16^0 mod 1, adds 0
+        {
+            uint64_t kk = k + i / 4;
+            e[i] = kk < k1 ? d - kk : 0;
+            m[i] = kk < k1 ? 8 * kk + BBP_J[i % 4] : 1;
+        }
+        powMod16xN(e, m, r);
+        for (int i = 0; i < BBP_LANES; i++)
+        {
+            s[i % 4] += (long double)r[i] / m[i];
+            s[i % 4] -= floorl(s[i % 4]);
+        }
+    }
+    if (k1 <= d)
+        return;
+    for (int i = 0; i < 4; i++)
+        for (uint64_t k = d + 1;; k++)
+        {
+            long double t = powl(16.0L, -(long double)(k - d)) / (8 * k + BBP_J[i]);
+            if (t < 1e-20L)
+                break;
+            s[i] += t;
+        }
+}
+
+/*
+ * Combine the four series s[0..3] (j = 1, 4, 5, 6) of one position.
+ */
+uint32_t bbpFrac(const long double s[4])
+{
+    long double f = 4 * s[0] - 2 * s[1] - s[2] - s[3];
+    f -= floorl(f);
+    return (uint32_t)(f * 4294967296.0L);
+}
+
+/*
+ * Check pi * 2^W against BBP at the VERIFY_POS hex positions (or at the last
+ * one covered by prec bits, which depends on every bit before it). The sum
+ * over k of every position is cut into THREADS chunks, each a task.
+ * Rounding in either value can flip the last bits, so the two 32-bit
+ * fractions only have to agree in their leading VERIFY_BITS.
+ */
+bool bbpVerify(const mpz_class &pi, long W, long prec)
+{
+    long last = (prec - 32) / 4;
+    vector<long> pos = VERIFY_POS;
+    if (pos.empty())
+        pos = {last};
+
+    // Every position is cut into chunks of k, one task each
+    size_t chunks = max<size_t>(1, THREADS);
+    vector<long double> series(4 * chunks * pos.size(), 0);
+    atomic<size_t> next(0);
+    auto worker = [&] {
+        for (size_t i; (i = next++) < chunks * pos.size();)
+        {
+            uint64_t d = pos[i / chunks], c = i % chunks;
+            if (pos[i / chunks] >= 0 && pos[i / chunks] <= last)
+                bbpSeries(d, (d + 1) * c / chunks, c + 1 == chunks ? d + 2 : (d + 1) * (c + 1) / chunks, &series[4 * i]);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned int i = 1; i < min<size_t>(THREADS, chunks * pos.size()); i++)
+        pool.push_back(thread(worker));
+    worker();
+    for (thread &th : pool)
+        th.join();
+    for (size_t p = 0; p < pos.size(); p++) // Chunk sums into the first chunk's
+        for (size_t c = 1; c < chunks; c++)
+            for (int i = 0; i < 4; i++)
+                series[4 * p * chunks + i] += series[4 * (p * chunks + c) + i];
+
+    bool ok = true;
+    uint32_t tol = 1u << (32 - VERIFY_BITS);
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        cout << "VERIFY        : hex digits after " << pos[i] << " ";
+        if (pos[i] < 0 || pos[i] > last)
+        {
+            cout << "out of range (0 - " << last << ")" << endl;
+            ok = false;
+            continue;
+        }
+        mpz_class bits = (pi >> (W - 4 * pos[i] - 32)) & 0xffffffffUL;
+        uint32_t got = bits.get_ui(), bbp = bbpFrac(&series[4 * i * chunks]);
+        uint32_t diff = got - bbp;
+        bool match = diff < tol || -diff < tol;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%06X (BBP %06X) ", got >> 8, bbp >> 8);
+        cout << buf << (match ? "OK" : "MISMATCH") << endl;
+        ok = ok && match;
+    }
+    return ok;
+}
+
+/*
+ * Out-of-core big integers
+ * Once installed, every GMP block of SWAP_MIN_BYTES or more lives in an
+ * unlinked file under the swap directory, mapped MAP_SHARED, instead of on
+ * the heap. The kernel writes cold P/Q/T limbs back to the file and pages
+ * them in again as the multiplications stream through them (the mappings
+ * are marked MADV_SEQUENTIAL), so the largest run is bounded by disk space
+ * rather than RAM. Smaller blocks still come from malloc().
+ */
+class SwapSpace
+{
+    static string dir;
+    static mutex mtx;
+    static map<void *, size_t> maps; // Mapped blocks and their sizes
+    static size_t bytes, peak;       // Bytes mapped, now and at most
+    static void *mapBlock(size_t size);
+    static bool isMapped(void *ptr);
+    static bool unmapBlock(void *ptr);
+
+public:
+    static void install(const string &dir);
+    static void *alloc(size_t size);
+    static void *realloc(void *ptr, size_t oldSize, size_t newSize);
+    static void free(void *ptr, size_t size);
+    static double peakMB() { return peak / 1048576.0; }
+};
+
+string SwapSpace::dir;
+mutex SwapSpace::mtx;
+map<void *, size_t> SwapSpace::maps;
+size_t SwapSpace::bytes = 0, SwapSpace::peak = 0;
+
+/*
+ * Route all GMP allocations through SwapSpace. Blocks that were already
+ * malloc()'ed are told apart by not being in `maps`.
+ */
+void SwapSpace::install(const string &dir)
+{
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        throw runtime_error("cannot create " + dir + ": " + strerror(errno));
+    SwapSpace::dir = dir;
+    mp_set_memory_functions(alloc, realloc, free);
+}
+
+void *SwapSpace::mapBlock(size_t size)
+{
+    string name = dir + "/chud_pi.XXXXXX";
+    int fd = mkstemp(&name[0]);
+    void *ptr = MAP_FAILED;
+    if (fd >= 0)
+    {
+        unlink(name.c_str());
+        if (ftruncate(fd, size) == 0)
+            ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (ptr == MAP_FAILED)
+    {
+        // GMP has no way to report a failed allocation either
+        cerr << "SWAP          : cannot map " << size << " bytes in " << dir
+             << ": " << strerror(errno) << endl;
+        abort();
+    }
+    madvise(ptr, size, MADV_SEQUENTIAL);
+
+    lock_guard<mutex> lock(mtx);
+    maps[ptr] = size;
+    bytes += size;
+    peak = max(peak, bytes);
+    return ptr;
+}
+
+bool SwapSpace::isMapped(void *ptr)
+{
+    lock_guard<mutex> lock(mtx);
+    return maps.count(ptr) != 0;
+}
+
+bool SwapSpace::unmapBlock(void *ptr)
+{
+    size_t size;
+    {
+        lock_guard<mutex> lock(mtx);
+        auto it = maps.find(ptr);
+        if (it == maps.end())
+            return false;
+        size = it->second;
+        bytes -= size;
+        maps.erase(it);
+    }
+    munmap(ptr, size);
+    return true;
+}
+
+void *SwapSpace::alloc(size_t size)
+{
+    if (size >= SWAP_MIN_BYTES)
+        return mapBlock(size);
+    void *ptr = ::malloc(size);
+    if (ptr == NULL)
+        throw bad_alloc();
+    return ptr;
+}
+
+void *SwapSpace::realloc(void *ptr, size_t oldSize, size_t newSize)
+{
+    if (newSize < SWAP_MIN_BYTES && !isMapped(ptr))
+    {
+        void *res = ::realloc(ptr, newSize);
+        if (res == NULL)
+            throw bad_alloc();
+        return res;
+    }
+    void *res = alloc(newSize);
+    memcpy(res, ptr, min(oldSize, newSize));
+    free(ptr, oldSize);
+    return res;
+}
+
+void SwapSpace::free(void *ptr, size_t)
+{
+    if (!unmapBlock(ptr))
+        ::free(ptr);
+}
+
+/*
+ * Streaming decimal output (divide-and-conquer radix conversion)
+ * The file is cut into WRITE_BLOCK-byte blocks: block 0 starts with the
+ * integer part and ".", every other block holds WRITE_BLOCK fraction digits.
+ * The fraction is split by 10^(WRITE_BLOCK * 2^j) until one block is left,
+ * which is then printed and written straight to its own offset with
+ * pwrite(). The halves convert on separate threads at the top levels, and
+ * block 0 hits the disk long before the last division is done.
+ */
+class DigitWriter
+{
+    int fd;                   // Output file
+    string head;              // Integer part and "."
+    long size, blocks;        // File size (bytes), number of blocks
+    int parDepth;             // Levels converted on separate threads
+    vector<mpz_class> pow10;  // pow10[j] = 10^(WRITE_BLOCK * 2^j)
+    atomic<int> error;        // errno of the first failed write
+    atomic<int64_t> convertNs, writeNs; // Time in radix conversion, in pwrite()
+    void convert(mpz_class &v, long b0, long b1, int depth);
+    void writeBlock(const mpz_class &v, long b, long n);
+
+public:
+    DigitWriter(const char *filename, const string &intPart, long digits);
+    ~DigitWriter();
+    void write(mpz_class &frac); // Write `digits` digits of frac / 10^digits
+    long fileSize() { return size; }
+    double convertSeconds() { return convertNs / 1e9; } // Summed over threads
+    double writeSeconds() { return writeNs / 1e9; }
+};
+
+DigitWriter::DigitWriter(const char *filename, const string &intPart,
+                         long digits)
+    : head(intPart + "."), size(intPart.size() + 1 + digits + 1), error(0),
+      convertNs(0), writeNs(0)
+{
+    fd = -1;
+#ifdef O_DIRECT
+    if (DIRECT_IO && (fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644)) < 0)
+        cerr << "O_DIRECT not supported here, using buffered writes." << endl;
+#endif
+    if (fd < 0 && (fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        throw runtime_error(string("cannot open ") + filename + ": " + strerror(errno));
+
+    blocks = (size + WRITE_BLOCK - 1) / WRITE_BLOCK;
+    parDepth = THREADS > 1 ? (int)ceil(log2(THREADS)) + 1 : 0;
+}
+
+DigitWriter::~DigitWriter()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+/*
+ * Print block b of the file (v holds its n digits) and write it.
+ */
+void DigitWriter::writeBlock(const mpz_class &v, long b, long n)
+{
+    long skip = b == 0 ? head.size() : 0;
+    char *buf, *tmp = new char[n + 2];
+    if (posix_memalign((void **)&buf, 4096, WRITE_BLOCK) != 0)
+        throw bad_alloc();
+
+    // Left-pad with the zeros mpz_get_str() leaves out
+    auto t0 = chrono::steady_clock::now();
+    mpz_get_str(tmp, 10, v.get_mpz_t());
+    long len = strlen(tmp);
+    memcpy(buf, head.data(), skip);
+    memset(buf + skip, '0', n - len);
+    memcpy(buf + skip + n - len, tmp, len);
+    delete[] tmp;
+
+    // The last block ends in the newline, the padding is truncated later
+    long off = b * WRITE_BLOCK;
+    if (b == blocks - 1)
+    {
+        buf[size - 1 - off] = '\n';
+        memset(buf + size - off, 0, WRITE_BLOCK - (size - off));
+    }
+    auto t1 = chrono::steady_clock::now();
+    if (pwrite(fd, buf, WRITE_BLOCK, off) != WRITE_BLOCK)
+    {
+        int zero = 0;
+        error.compare_exchange_strong(zero, errno ? errno : EIO);
+    }
+    auto t2 = chrono::steady_clock::now();
+    convertNs += chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+    writeNs += chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+    free(buf);
+}
+
+/*
+ * Convert v, the digits of blocks [b0, b1), freeing v on the way down.
+ */
+void DigitWriter::convert(mpz_class &v, long b0, long b1, int depth)
+{
+    if (b1 - b0 == 1)
+    {
+        writeBlock(v, b0, WRITE_BLOCK - (b0 == 0 ? head.size() : 0));
+        release(v);
+        return;
+    }
+
+    // The low part takes the largest power-of-two number of blocks
+    int j = 0;
+    while ((2L << j) < b1 - b0)
+        j++;
+    long m = b1 - (1L << j);
+    mpz_class hi, lo;
+    auto t0 = chrono::steady_clock::now();
+    mpz_tdiv_qr(hi.get_mpz_t(), lo.get_mpz_t(), v.get_mpz_t(), pow10[j].get_mpz_t());
+    convertNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    release(v);
+
+    if (depth < parDepth)
+    {
+        thread th([&] { convert(hi, b0, m, depth + 1); });
+        convert(lo, m, b1, depth + 1);
+        th.join();
+    }
+    else
+    {
+        convert(hi, b0, m, depth + 1);
+        convert(lo, m, b1, depth + 1);
+    }
+}
+
+void DigitWriter::write(mpz_class &frac)
+{
+    long digits = size - head.size() - 1;
+    if (blocks == 1)
+    {
+        writeBlock(frac, 0, digits);
+    }
+    else
+    {
+        // Pad frac with zeros to fill the last block
+        long room = blocks * WRITE_BLOCK - head.size();
+        mpz_class pad;
+        mpz_ui_pow_ui(pad.get_mpz_t(), 10, room - digits);
+        frac *= pad;
+
+        pow10.resize(1);
+        mpz_ui_pow_ui(pow10[0].get_mpz_t(), 10, WRITE_BLOCK);
+        while ((2L << (pow10.size() - 1)) < blocks)
+            pow10.push_back(pow10.back() * pow10.back());
+
+        convert(frac, 0, blocks, 0);
+        pow10.clear();
+    }
+
+    if (error == 0 && ftruncate(fd, size) != 0)
+        error = errno;
+    if (error != 0)
+        throw runtime_error(string("write failed: ") + strerror(error));
+}
+
+/*
+ * Checkpoints of finished compPQT subtrees
+ * A subtree is stored as <dir>/<const>_<n1>_<n2>.pqt: a header, then P, Q and T
+ * each as a signed limb count followed by the raw limbs, so a file reads
+ * straight back into the mpz (or can be mmap'ed) without any conversion.
+ * Files are written by a background thread from a copy of the result, and
+ * once a parent is on disk its children's files are removed. P, Q and T of
+ * a range only depend on n1 and n2, so a resumed run may ask for a
+ * different number of digits.
+ */
+struct CkptHeader
+{
+    char magic[8];
+    int64_t n1, n2, hasP, limbBits;
+};
+
+class Checkpointer
+{
+    string dir;                                 // Scratch directory
+    string prefix;                              // Constant being computed
+    deque<pair<pair<long, long>, PQT>> pending; // Results not yet on disk
+    mutex mtx;
+    condition_variable cv;
+    bool stop;
+    thread worker;
+    string path(long n1, long n2);
+    void store(long n1, long n2, const PQT &res);
+    void run();
+
+public:
+    Checkpointer(const string &dir, const string &prefix);
+    ~Checkpointer(); // Drains the queue
+    void save(long n1, long n2, const PQT &res);
+    bool load(long n1, long n2, bool needP, PQT &res);
+};
+
+Checkpointer::Checkpointer(const string &dir, const string &prefix)
+    : dir(dir), prefix(prefix), stop(false)
+{
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        throw runtime_error("cannot create " + dir + ": " + strerror(errno));
+    worker = thread(&Checkpointer::run, this);
+}
+
+Checkpointer::~Checkpointer()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+string Checkpointer::path(long n1, long n2)
+{
+    return dir + "/" + prefix + "_" + to_string(n1) + "_" + to_string(n2) + ".pqt";
+}
+
+/*
+ * Queue a copy of res, so the caller can go on merging it.
+ */
+void Checkpointer::save(long n1, long n2, const PQT &res)
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        pending.push_back(make_pair(make_pair(n1, n2), res));
+    }
+    cv.notify_one();
+}
+
+void Checkpointer::run()
+{
+    unique_lock<mutex> lock(mtx);
+    while (true)
+    {
+        cv.wait(lock, [this] { return stop || !pending.empty(); });
+        if (pending.empty())
+            return;
+        auto item = move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        store(item.first.first, item.first.second, item.second);
+        lock.lock();
+    }
+}
+
+/*
+ * Write one subtree (to a temporary file first, so a kill mid-write never
+ * leaves a truncated checkpoint behind), then drop its children.
+ */
+void Checkpointer::store(long n1, long n2, const PQT &res)
+{
+    string name = path(n1, n2), tmp = name + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    bool ok = fp != NULL;
+    CkptHeader hdr = {{'B', 'S', 'P', 'L', 'I', 'T', 'v', '2'},
+                      n1, n2, res.P != 0, GMP_NUMB_BITS};
+    if (ok)
+        ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    for (const mpz_class *x : {&res.P, &res.Q, &res.T})
+    {
+        int64_t n = x->get_mpz_t()->_mp_size;
+        size_t limbs = mpz_size(x->get_mpz_t());
+        if (ok)
+            ok = fwrite(&n, sizeof(n), 1, fp) == 1 &&
+                 fwrite(mpz_limbs_read(x->get_mpz_t()), sizeof(mp_limb_t), limbs, fp) == limbs;
+    }
+    if (fp != NULL)
+        ok = fflush(fp) == 0 && fsync(fileno(fp)) == 0 && fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), name.c_str()) != 0)
+    {
+        cerr << "CHECKPOINT    : cannot write " << name << ": " << strerror(errno) << endl;
+        remove(tmp.c_str());
+        return;
+    }
+
+    long m = (n1 + n2) / 2;
+    remove(path(n1, m).c_str());
+    remove(path(m, n2).c_str());
+}
+
+/*
+ * Read a subtree back, if it has been saved (with P, when needP is set).
+ */
+bool Checkpointer::load(long n1, long n2, bool needP, PQT &res)
+{
+    FILE *fp = fopen(path(n1, n2).c_str(), "rb");
+    if (fp == NULL)
+        return false;
+    CkptHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, fp) == 1 &&
+              memcmp(hdr.magic, "BSPLITv2", 8) == 0 &&
+              hdr.n1 == n1 && hdr.n2 == n2 && hdr.limbBits == GMP_NUMB_BITS &&
+              (hdr.hasP || !needP);
+    for (mpz_class *x : {&res.P, &res.Q, &res.T})
+    {
+        int64_t n;
+        if (ok)
+            ok = fread(&n, sizeof(n), 1, fp) == 1;
+        if (ok)
+        {
+            size_t limbs = n < 0 ? -n : n;
+            mp_limb_t *xp = mpz_limbs_write(x->get_mpz_t(), max<size_t>(limbs, 1));
+            ok = fread(xp, sizeof(mp_limb_t), limbs, fp) == limbs;
+            mpz_limbs_finish(x->get_mpz_t(), ok ? n : 0);
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+/*
+ * Series
+ * Each constant is a hypergeometric series
+ *     S = a(0) + sum_{n>=1} a(n) * prod_{k=1..n} p(k) / q(k)
+ * given by its term functions, the number of terms for a digit count, and a
+ * finish() that turns X = a(0) * Q + T and Q of the whole range into
+ * value * 2^W (consuming both). BBP tells if the hex spot check applies.
+ */
+
+/*
+ * Chudnovsky: 1 / pi = 12 / 640320^(3/2) * sum (-1)^n (6n)! (A + B n) /
+ * ((3n)! (n!)^3 640320^(3n)), so pi = D * sqrt(E) * Q / (A * Q + T).
+ */
+struct ChudnovskyPi
+{
+    static const bool BBP = true;
+    static const char *name() { return "pi"; }
+    static long terms(long digits)
+    {
+        return digits / 14.1816474627254776555 + 1; // log(53360^3) / log(10)
+    }
+    static void p(mpz_class &r, long n)
+    {
+        r = -(2 * n - 1);
+        r *= 6 * n - 1;
+        r *= 6 * n - 5;
+    }
+    static void q(mpz_class &r, long n)
+    {
+        r = 10939058860032000UL; // 640320^3 / 24
+        r *= n;
+        r *= n;
+        r *= n;
+    }
+    static void a(mpz_class &r, long n)
+    {
+        r = 545140134;
+        r *= n;
+        r += 13591409;
+    }
+
+    /*
+     * Works on the top W bits of Q and A * Q + T. 1/sqrt(E) and
+     * Q / (A * Q + T) come from Newton iterations, and D * E is folded into
+     * 1/sqrt(E) for free, so the two meet in a single final multiplication.
+     */
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        const unsigned long D = 426880, E = 10005;
+        long scale;
+        mpz_class u = fixQuotient(Q, X, W, scale), c, pi;
+
+        // c = D * E / sqrt(E) * 2^W
+        fixInvSqrt(c, E, W, THREADS);
+        c *= D * E;
+
+        parMul(pi, c, u, THREADS);
+        return pi >> (W - scale);
+    }
+};
+
+/*
+ * e = sum 1 / n!
+ */
+struct EulerE
+{
+    static const bool BBP = false;
+    static const char *name() { return "e"; }
+    static long terms(long digits)
+    {
+        // Smallest n with log10(n!) past the digits
+        long n = 1;
+        while (lgamma(n + 1.0) / log(10.0) < digits + 1)
+            n = max(n + 1, (long)(n * 1.1));
+        return n;
+    }
+    static void p(mpz_class &r, long) { r = 1; }
+    static void q(mpz_class &r, long n) { r = n; }
+    static void a(mpz_class &r, long) { r = 1; }
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        return fixValue(X, Q, W, 1, 1);
+    }
+};
+
+/*
+ * ln 2 = 3/4 * sum (-1)^n (n!)^2 / (2^n (2n+1)!)
+ */
+struct Ln2
+{
+    static const bool BBP = false;
+    static const char *name() { return "ln2"; }
+    static long terms(long digits)
+    {
+        return digits / 0.90308998699194353856 + 1; // log(8) / log(10)
+    }
+    static void p(mpz_class &r, long n) { r = -n; }
+    static void q(mpz_class &r, long n) { r = 4 * (2 * n + 1); }
+    static void a(mpz_class &r, long) { r = 1; }
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        return fixValue(X, Q, W, 3, 4);
+    }
+};
+
+/*
+ * sqrt 2 = 7/5 * (1 - 1/50)^(-1/2) = 7/5 * sum (2n)! / ((n!)^2 200^n)
+ */
+struct Sqrt2
+{
+    static const bool BBP = false;
+    static const char *name() { return "sqrt2"; }
+    static long terms(long digits)
+    {
+        return digits / 1.69897000433601880479 + 1; // log(50) / log(10)
+    }
+    static void p(mpz_class &r, long n) { r = 2 * n - 1; }
+    static void q(mpz_class &r, long n) { r = 100 * n; }
+    static void a(mpz_class &r, long) { r = 1; }
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        return fixValue(X, Q, W, 7, 5);
+    }
+};
+
+/*
+ * zeta(3) = 1/64 * sum (-1)^n (205n^2 + 250n + 77) (n!)^10 / ((2n+1)!)^5
+ * (Amdeberhan-Zeilberger)
+ */
+struct Zeta3
+{
+    static const bool BBP = false;
+    static const char *name() { return "zeta3"; }
+    static long terms(long digits)
+    {
+        return digits / 3.01029995663981195214 + 1; // log(1024) / log(10)
+    }
+    static void p(mpz_class &r, long n)
+    {
+        r = -n; // -n^5, one factor at a time: n^3 overflows long
+        r *= n;
+        r *= n;
+        r *= n;
+        r *= n;
+    }
+    static void q(mpz_class &r, long n)
+    {
+        mpz_ui_pow_ui(r.get_mpz_t(), 2 * n + 1, 5);
+        r *= 32;
+    }
+    static void a(mpz_class &r, long n)
+    {
+        r = 205 * n + 250;
+        r *= n;
+        r += 77;
+    }
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        return fixValue(X, Q, W, 1, 64);
+    }
+};
+
+/*
+ * Catalan's constant, from Lupas' series
+ * G = 1/64 * sum_{n>=1} (-1)^(n-1) 256^n (40n^2 - 24n + 3) ((2n)!)^3 (n!)^2 /
+ *     (n^3 (2n-1) ((4n)!)^2),
+ * shifted to start at n = 0, which folds the rational factor into the term
+ * ratio: G = 1/18 * (19 + sum a(n) prod p(k) / q(k)).
+ */
+struct Catalan
+{
+    static const bool BBP = false;
+    static const char *name() { return "catalan"; }
+    static long terms(long digits)
+    {
+        return digits / 0.60205999132796239042 + 1; // log(4) / log(10)
+    }
+    static void p(mpz_class &r, long n)
+    {
+        r = -32 * n;
+        r *= n;
+        r *= n;
+        r *= 2 * n - 1;
+    }
+    static void q(mpz_class &r, long n)
+    {
+        r = 4 * n + 1;
+        r *= 4 * n + 3;
+        r *= r;
+    }
+    static void a(mpz_class &r, long n)
+    {
+        r = 40 * n + 56;
+        r *= n;
+        r += 19;
+    }
+    static mpz_class finish(mpz_class &X, mpz_class &Q, long W)
+    {
+        return fixValue(X, Q, W, 1, 18);
+    }
+};
+
+/*
+ * Binary splitting engine
+ * Evaluates a Series (see above) to DIGITS digits, with the parallel,
+ * memory-lean, checkpointed split tree and the streaming output.
+ */
+template <class Series>
+class BinarySplit
 {
     // Declaration
-    mpz_class A, B, C, D, E, C3_24; // GMP Integer
-    int PREC, N;                    // Integer
-    double DIGITS_PER_TERM;         // Long
-    clock_t t0, t1, t2;             // Time
-    PQT compPQT(int n1, int n2);    // Computer PQT (by BSA)
+    long PREC, N;                            // Integer
+    int PAR_DEPTH;                           // Levels forked onto threads
+    unique_ptr<Checkpointer> ckpt;           // Subtree checkpoints (optional)
+    chrono::steady_clock::time_point t0, t1, t2; // Time (wall clock)
+    PQT compPQT(long n1, long n2, int depth, bool needP); // Computer PQT (by BSA)
+    void mergeLean(PQT &res1, PQT &res2, bool needP, int threads);
 
 public:
-    Chudnovsky();  // Constructor
-    void compPi(); // Compute PI
+    BinarySplit();  // Constructor
+    bool compute(); // Compute the constant (false if verification failed)
 };
 
 /*
  * Constructor
  */
-Chudnovsky::Chudnovsky()
-{
-    // Constants
-    // DIGITS = 1000;   // prompt for user input
-    A = 13591409;
-    B = 545140134;
-    C = 640320;
-    D = 426880;
-    E = 10005;
-    DIGITS_PER_TERM = 14.1816474627254776555; // = log(53360^3) / log(10)
-    C3_24 = C * C * C / 24;
-    N = DIGITS / DIGITS_PER_TERM;
+template <class Series>
+BinarySplit<Series>::BinarySplit()
+{
+    N = Series::terms(DIGITS);
     PREC = DIGITS * log2(10);
+
+    // Fork log2(THREADS) levels plus two more, so the uneven halves of the
+    // split tree (terms grow with n) still keep every core busy.
+    PAR_DEPTH = 0;
+    if (THREADS > 1)
+        PAR_DEPTH = (int)ceil(log2(THREADS)) + 2;
+
+    if (!CKPT_DIR.empty())
+        ckpt.reset(new Checkpointer(CKPT_DIR, Series::name()));
+}
+
+/*
+ * Merge res2 into res1 in place, freeing each part of res2 (and P of res1
+ * when the caller has no use for it) as soon as it has been consumed.
+ */
+template <class Series>
+void BinarySplit<Series>::mergeLean(PQT &res1, PQT &res2, bool needP, int threads)
+{
+    // T = T1 * Q2 + P1 * T2
+    parMul(res1.T, res1.T, res2.Q, threads);
+    parMul(res2.T, res1.P, res2.T, threads);
+    res1.T += res2.T;
+    release(res2.T);
+
+    // P = P1 * P2
+    if (needP)
+        parMul(res1.P, res1.P, res2.P, threads);
+    else
+        release(res1.P);
+    release(res2.P);
+
+    // Q = Q1 * Q2
+    parMul(res1.Q, res1.Q, res2.Q, threads);
+    release(res2.Q);
 }
 
 /*
  * Compute PQT (by Binary Splitting Algorithm)
+ * A leaf n is P = p(n), Q = q(n), T = a(n) * p(n); a merge is P = P1 * P2,
+ * Q = Q1 * Q2, T = T1 * Q2 + P1 * T2.
+ * The two halves are independent, so the top PAR_DEPTH levels run the left
+ * half on a new thread while this thread takes the right half.
+ * P is only built when needP is set: the root's P is never used, and neither
+ * is the P of a right child whose parent does not need one.
+ * Subtrees of CKPT_MIN_TERMS or more are checkpointed, and reloaded on resume.
  */
-PQT Chudnovsky::compPQT(int n1, int n2)
+template <class Series>
+PQT BinarySplit<Series>::compPQT(long n1, long n2, int depth, bool needP)
 {
-    int m;
+    long m;
     PQT res;
+    bool ckptNode = ckpt && n2 - n1 >= CKPT_MIN_TERMS;
+
+    if (ckptNode && RESUME && ckpt->load(n1, n2, needP, res))
+        return res;
 
     if (n1 + 1 == n2)
     {
-        res.P = (2 * n2 - 1);
-        res.P *= (6 * n2 - 1);
-        res.P *= (6 * n2 - 5);
-        res.Q = C3_24 * n2 * n2 * n2;
-        res.T = (A + B * n2) * res.P;
-        if ((n2 & 1) == 1)
-            res.T = -res.T;
+        Series::p(res.P, n2);
+        Series::q(res.Q, n2);
+        Series::a(res.T, n2);
+        res.T *= res.P;
+        if (!needP)
+            release(res.P);
     }
     else
     {
         m = (n1 + n2) / 2;
-        PQT res1 = compPQT(n1, m);
-        PQT res2 = compPQT(m, n2);
-        res.P = res1.P * res2.P;
-        res.Q = res1.Q * res2.Q;
-        res.T = res1.T * res2.Q + res1.P * res2.T;
+        PQT res1, res2;
+        if (depth < PAR_DEPTH && n2 - n1 >= PAR_MIN_TERMS)
+        {
+            thread th([&] { res1 = compPQT(n1, m, depth + 1, true); });
+            res2 = compPQT(m, n2, depth + 1, needP);
+            th.join();
+        }
+        else
+        {
+            res1 = compPQT(n1, m, depth + 1, true);
+            res2 = compPQT(m, n2, depth + 1, needP);
+        }
+        // Threads this subtree owns; the top levels run the four products
+        // side by side and split each one further with parMul().
+        // Lean mode does them one at a time, in place, to cap the peak.
+        int threads = max(1, (int)THREADS >> depth);
+        Stats::Merge stat(depth, res1, res2, needP);
+        if (LEAN)
+        {
+            mergeLean(res1, res2, needP, threads);
+            res = move(res1);
+        }
+        else if (threads > 1)
+        {
+            mpz_class T2;
+            int sub = max(1, threads / 4);
+            thread thP([&] {
+                if (needP)
+                    parMul(res.P, res1.P, res2.P, sub);
+            });
+            thread thQ([&] { parMul(res.Q, res1.Q, res2.Q, sub); });
+            thread thT([&] { parMul(res.T, res1.T, res2.Q, sub); });
+            parMul(T2, res1.P, res2.T, max(1, threads - 3 * sub));
+            thP.join();
+            thQ.join();
+            thT.join();
+            res.T += T2;
+        }
+        else
+        {
+            mpz_class T2;
+            if (needP)
+                parMul(res.P, res1.P, res2.P, 1);
+            parMul(res.Q, res1.Q, res2.Q, 1);
+            parMul(res.T, res1.T, res2.Q, 1);
+            parMul(T2, res1.P, res2.T, 1);
+            res.T += T2;
+        }
+        stat.done();
     }
 
+    if (ckptNode)
+        ckpt->save(n1, n2, res);
     return res;
 }
 
 /*
- * Compute PI
+ * Compute the constant
  */
-void Chudnovsky::compPi()
+template <class Series>
+bool BinarySplit<Series>::compute()
 {
-    cout << "**** PI Computation ( " << DIGITS << " digits )" << endl;
+    cout << "**** " << Series::name() << " Computation ( " << DIGITS
+         << " digits, " << THREADS << " threads )" << endl;
 
     // Time (start)
-    t0 = clock();
+    t0 = chrono::steady_clock::now();
+    STATS.begin("series");
 
-    // Compute Pi
-    PQT PQT = compPQT(0, N);
-    mpf_class pi(0, PREC);
-    pi = D * sqrt((mpf_class)E) * PQT.Q;
-    pi /= (A * PQT.Q + PQT.T);
+    // Compute the value (fixed point, W fraction bits)
+    PQT PQT = compPQT(0, N, 0, false);
+    auto tSeries = chrono::steady_clock::now();
+    STATS.begin("finish");
+    long W = PREC + FINISH_GUARD;
+    mpz_class X;
+    Series::a(X, 0);
+    X *= PQT.Q;
+    X += PQT.T;
+    release(PQT.T);
+    mpz_class value = Series::finish(X, PQT.Q, W);
 
     // Time (end of computation)
-    t1 = clock();
-    cout << "TIME (COMPUTE): "
-         << (double)(t1 - t0) / CLOCKS_PER_SEC
-         << " seconds." << endl;
+    t1 = chrono::steady_clock::now();
+    cout << "TIME (SERIES) : "
+         << chrono::duration<double>(tSeries - t0).count()
+         << " seconds." << endl
+         << "TIME (FINISH) : "
+         << chrono::duration<double>(t1 - tSeries).count()
+         << " seconds." << endl
+         << "TIME (COMPUTE): "
+         << chrono::duration<double>(t1 - t0).count()
+         << " seconds." << endl
+         << "PEAK RSS      : " << peakRSS() << " MB." << endl;
+    if (!SWAP_DIR.empty())
+        cout << "PEAK SWAP     : " << SwapSpace::peakMB() << " MB." << endl;
+
+    // Verify
+    bool ok = true;
+    if (VERIFY && !Series::BBP)
+    {
+        cout << "VERIFY        : no spot check for " << Series::name() << endl;
+    }
+    else if (VERIFY)
+    {
+        STATS.begin("verify");
+        ok = bbpVerify(value, W, PREC);
+        auto tVerify = chrono::steady_clock::now();
+        cout << "TIME (VERIFY) : "
+             << chrono::duration<double>(tVerify - t1).count()
+             << " seconds (" << chrono::duration<double>(tVerify - t1) / (t1 - t0)
+             << " of compute)." << endl;
+        t1 = tVerify;
+    }
 
     // Output
     if (FILENAME != NULL)
     {
-        ofstream ofs(FILENAME);
-        ofs.precision(DIGITS + 1);
-        ofs << pi << endl;
+        STATS.begin("output");
 
-        // Time (end of writing)
-        t2 = clock();
+        // Fraction digits as an integer:
+        // floor(value * 10^DIGITS) - floor(value) * 10^DIGITS
+        mpz_class scale, frac, whole = value >> W;
+        mpz_ui_pow_ui(scale.get_mpz_t(), 10, DIGITS);
+        parMul(frac, value, scale, THREADS);
+        frac >>= W;
+        frac -= whole * scale;
+        release(scale);
+        release(value);
+
+        DigitWriter out(FILENAME, whole.get_str(), DIGITS);
+        out.write(frac);
+        STATS.note("radix_busy", out.convertSeconds());
+        STATS.note("write_busy", out.writeSeconds());
 
-        // Get file size
-        ifstream in(FILENAME, ios::binary | ios::ate);
+        // Time (end of writing)
+        t2 = chrono::steady_clock::now();
 
         cout << "TIME (WRITE)  : "
-             << (double)(t2 - t1) / CLOCKS_PER_SEC
+             << chrono::duration<double>(t2 - t1).count()
              << " seconds." << endl
              << "FILE SAVED    : " << FILENAME
-             << " ( " << in.tellg() << " BYTES )" << endl;
+             << " ( " << out.fileSize() << " BYTES )" << endl;
+    }
+
+    if (!STATS_FILE.empty())
+    {
+        STATS.save(STATS_FILE, Series::name(), N);
+        cout << "STATS SAVED   : " << STATS_FILE << endl;
     }
+    return ok;
 }
 
 int main(int argc, char **argv)
 {
+    static const struct option LONG_OPTS[] = {
+        {"const", required_argument, NULL, 'c'},
+        {"threads", required_argument, NULL, 't'},
+        {"lean", no_argument, NULL, 'l'},
+        {"direct", no_argument, NULL, 'd'},
+        {"checkpoint", required_argument, NULL, 'k'},
+        {"resume", no_argument, NULL, 'r'},
+        {"swap", required_argument, NULL, 's'},
+        {"verify", optional_argument, NULL, 'v'},
+        {"stats", required_argument, NULL, 'j'},
+        {NULL, 0, NULL, 0}};
+    int opt;
+
     // Check cmd line args
-    if (argc <= 1 || argc > 3)
+    while ((opt = getopt_long(argc, argv, "c:t:ldk:rs:v::j:", LONG_OPTS, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            CONSTANT = optarg;
+            break;
+        case 't':
+            THREADS = stoi(optarg);
+            break;
+        case 'l':
+            LEAN = true;
+            break;
+        case 'd':
+            DIRECT_IO = true;
+            break;
+        case 'k':
+            CKPT_DIR = optarg;
+            break;
+        case 'r':
+            RESUME = true;
+            break;
+        case 's':
+            SWAP_DIR = optarg;
+            break;
+        case 'v':
+            VERIFY = true;
+            if (optarg != NULL)
+            {
+                stringstream list(optarg);
+                string pos;
+                while (getline(list, pos, ','))
+                    VERIFY_POS.push_back(stol(pos));
+            }
+            break;
+        case 'j':
+            STATS_FILE = optarg;
+            STATS.enabled = true;
+            break;
+        default:
+            cerr << MSG_USAGE;
+            return 1;
+        }
+    }
+    if (argc - optind < 1 || argc - optind > 2 || THREADS < 1 ||
+        (RESUME && CKPT_DIR.empty()))
     {
         cerr << MSG_USAGE;
         return 1;
     }
-    cout << "Compute pi(π) by Binary Splitting Algorithm with GMP libarary."
-         << endl;
+    cout << "Compute " << (CONSTANT == "pi" ? "pi(π)" : CONSTANT)
+         << " by Binary Splitting Algorithm with GMP libarary." << endl;
 
-    DIGITS = stoi(argv[1]);
-    FILENAME = argv[2];
+    DIGITS = stoi(argv[optind]);
+    FILENAME = argv[optind + 1];
 
     try
     {
-        // Instantiation
-        Chudnovsky objMain;
+        // Must come before the first GMP allocation
+        if (!SWAP_DIR.empty())
+            SwapSpace::install(SWAP_DIR);
 
-        // Compute PI
-        objMain.compPi();
+        // Instantiation and computation
+        bool ok;
+        if (CONSTANT == "pi")
+            ok = BinarySplit<ChudnovskyPi>().compute();
+        else if (CONSTANT == "e")
+            ok = BinarySplit<EulerE>().compute();
+        else if (CONSTANT == "ln2")
+            ok = BinarySplit<Ln2>().compute();
+        else if (CONSTANT == "sqrt2")
+            ok = BinarySplit<Sqrt2>().compute();
+        else if (CONSTANT == "zeta3")
+            ok = BinarySplit<Zeta3>().compute();
+        else if (CONSTANT == "catalan")
+            ok = BinarySplit<Catalan>().compute();
+        else
+        {
+            cerr << MSG_USAGE;
+            return 1;
+        }
+        if (!ok)
+            return 2;
+    }
+    catch (const exception &e)
+    {
+        cout << "ERROR! " << e.what() << endl;
+        return -1;
     }
     catch (...)
     {
@@ -7,21 +7,248 @@
 #include <random>
 #include <iomanip>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "SearchLib.h"
 using namespace std;
 
-const int MAX = 999999; // Size of data dictionary
+const string MSG_USAGE = "Usage:\nsearch_comp [options]\n\nOptions:\n\t-e, --eytzinger\t\tAlso build the dictionary in Eytzinger (BFS) order\n\t-b, --btree\t\tAlso build the static B+tree (S-tree) index\n\t-z, --sweep <MB>\tTime Binary, Eytzinger and S-tree from 4 KB up to <MB> of keys\n\t-s, --simd <isa>\tScan kernels: avx512, avx2, sse4.2 or scalar\n\t\t\t\t(default: the widest the CPU supports)\n\t-x, --crossover\t\tTime SIMD scan vs Binary on small sorted ranges\n\t-p, --pgm[=eps]\t\tAlso build the learned (PGM) index, error eps (default: 64)\n\t-g, --dist <name>\tKey distribution: uniform (default), lognormal, power\n\t\t\t\tor dups (about 1000 copies of each key)\n\t-c, --concurrent[=ms]\tQPS and latency of every search from 1 to -t threads\n\t\t\t\t(ms per measurement, default: 200)\n\t-t, --threads <k>\tMax query threads (default: all cores)\n\t-n, --size <keys>\tKeys in the dictionary, drawn from [0, keys] (default: 999999)\n\t-w, --save <file>\tSave the dictionary and its -e/-b indexes to <file>\n\t-o, --open <file>\tMap a saved dictionary instead of building one\n\t-P, --populate\t\tPrefault the mapping (MAP_POPULATE)\n\t-H, --hugepages\t\tAsk for transparent huge pages on the mapping\n\t-C, --cold\t\tTime lookups on evicted pages, then warm ones\n\t-r, --range[=width]\tTime lower_bound, equal_range and range queries\n\t\t\t\tover [k, k + width] (default width: 1000)\n\t-T, --types\t\tTime the searches on int, uint64_t, float and char[16] keys\n\t-a, --hash\t\tAlso build the SIMD hash index and the minimal perfect\n\t\t\t\thash, and compare every index's build time and size\n\nExample:\nsearch_comp -e -b -z 2048\n";
+
+int MAX = 999999;       // Size of data dictionary
 const int MIN = 0;
+const int BATCH = 1 << 20; // Keys per batched lookup benchmark
+const int JUMP_SLICE = 16;  // Jump search is timed on BATCH / JUMP_SLICE keys
+const int LINE_INTS = 16;  // Ints per 64-byte cache line
+const int STREE_B = 16;    // Keys per S-tree node, a multiple of LINE_INTS
+const int STREE_MAX_H = 16; // Max S-tree layers
+const int PGM_EPS_REC = 16; // Error bound of the learned index upper levels
+const int QUERY_KEYS = 1 << 16; // Keys each query thread cycles through
+const int LAT_SAMPLE = 64;      // Query threads time at most one lookup in LAT_SAMPLE
+const int LAT_WANT = 10000;     // Latency samples a query thread aims for per window
+const int LAT_TAIL = 10;        // Samples beyond a percentile needed to print it
+const int COLD_KEYS = 1024;     // Lookups timed on cold pages, per search
+const long PAGE = 4096;         // Alignment of the sections of a saved dictionary
+const int HASH_GROUP = 16;      // Slots per hash group, one SIMD compare
+const double HASH_LOAD = 0.875; // Max hash index load factor
+const int8_t HASH_EMPTY = -128; // Control byte of an empty slot
+const int MPH_BUCKET = 4;       // Mean keys per perfect hash bucket
+const int DUP_COPIES = 1000;    // Mean copies per key with -g dups
+const char DICT_MAGIC[8] = {'S', 'R', 'C', 'H', 'D', 'I', 'C', '1'};
 
-int *arr; // Gloable data dictionary
-int key;  // The key number to be searched for
+int *arr;          // Gloable data dictionary
+int *eyt = NULL;   // The dictionary in Eytzinger order (1-based), if built
+int *eytIdx;       // Index in arr of each eyt[] slot
+int key;           // The key number to be searched for
+bool EYTZINGER = false;
+bool BTREE = false;
+long SWEEP_MB = 0;
+string SIMD_CAP;
+bool CROSSOVER = false;
+int PGM_EPS = 0;           // Learned index error bound, 0 if not built
+string DIST = "uniform";
+int CONCURRENT_MS = 0;     // Window per concurrent measurement, 0 if off
+unsigned THREADS = thread::hardware_concurrency();
+string SAVE_FILE;
+string OPEN_FILE;
+bool POPULATE = false;
+bool HUGEPAGES = false;
+bool COLD = false;
+int RANGE_WIDTH = -1;      // Width of the range queries, -1 if off
+bool TYPES = false;
+bool HASH = false;
+char *MAPPED = NULL;       // Mapped dictionary file, if opened
+size_t MAPPED_BYTES;
 
-/* 1. SequenceSearch
- * A linear search sequentially checks each element of the list until it 
- * finds an element that matches the target value. If the algorithm reaches
- * the end of the list, the search terminates unsuccessfully.
- * Average Search Length (ASL) = (n+1) / 2, Average performance O(n/2), Space:O(1)
+/* 10. STreeSearch
+ * A static, implicit B+tree: layer 0 holds the sorted keys in nodes of
+ * STREE_B (padded with INT_MAX), and every upper layer holds, for each node,
+ * the smallest key of each of its STREE_B+1 children but the first. Nodes are
+ * line aligned, so a search costs one miss per layer, log(B+1) n in all
+ * instead of the log2 n of BinarySearch. Within a node the keys smaller than
+ * T are counted with SIMD compares; that count is the child
+ * to descend into, and on layer 0 it is the lower bound itself.
+ * O(log n), Space: about n (1 + 1/B) keys.
  */
-int SequenceSearch(int A[], int n, int T)
+struct STree
+{
+    int *key;               // All layers, line aligned, layer 0 first
+    long n;                 // Keys indexed
+    int height;             // Number of layers
+    long off[STREE_MAX_H];  // Start of each layer in key[]
+    long size;              // Ints in key[]
+};
+
+STree stree = {NULL, 0, 0, {0}, 0}; // S-tree over arr, if built
+
+static long streeBlocks(long n) { return (n + STREE_B - 1) / STREE_B; }
+static long streeUpper(long n) { return (streeBlocks(n) + STREE_B) / (STREE_B + 1) * STREE_B; }
+
+/* Layer count, layer starts and size of the S-tree over n keys */
+static void streeShape(long n, STree &S)
+{
+    long m = n;
+    S.n = n;
+    S.height = 1;
+    S.off[0] = 0;
+    for (; m > STREE_B; m = streeUpper(m))
+    {
+        if (S.height == STREE_MAX_H)
+            throw length_error("S-tree too tall");
+        S.off[S.height] = S.off[S.height - 1] + streeBlocks(m) * STREE_B;
+        S.height++;
+    }
+    S.size = S.off[S.height - 1] + max(1L, streeBlocks(m)) * STREE_B;
+}
+
+void BuildSTree(const int A[], long n, STree &S)
+{
+    streeShape(n, S);
+    long size = S.size;
+    S.key = (int *)aligned_alloc(64, size * sizeof(int));
+    if (S.key == NULL)
+        throw bad_alloc();
+
+    // Layer 0 is the array itself, padded
+    memcpy(S.key, A, n * sizeof(int));
+    fill(S.key + n, S.key + max(1L, streeBlocks(n)) * STREE_B, INT_MAX);
+
+    // Slot j of node k on layer h: first key of child j+1, then always its
+    // leftmost descendant down to layer 0
+    for (int h = 1; h < S.height; h++)
+    {
+        long len = (h + 1 < S.height ? S.off[h + 1] : size) - S.off[h];
+        for (long i = 0; i < len; i++)
+        {
+            long k = i / STREE_B, j = i - k * STREE_B;
+            k = k * (STREE_B + 1) + j + 1;
+            for (int l = 1; l < h; l++)
+                k *= (STREE_B + 1);
+            S.key[S.off[h] + i] = (k * STREE_B < n) ? S.key[k * STREE_B] : INT_MAX;
+        }
+    }
+}
+
+/*
+ * Count of keys in node y smaller than T. Each instruction set gets its own
+ * descent, compiled for it with popcnt so the rank inlines and its popcount
+ * is one instruction (a default build would call libgcc for it).
+ * SelectScanKernels picks one at startup from the CPU, as for the scans.
+ */
+static inline unsigned streeRankScalar(const int *y, int T)
+{
+    unsigned r = 0;
+    for (int i = 0; i < STREE_B; i++)
+        r += y[i] < T;
+    return r;
+}
+
+static long streeLowerBoundScalar(const STree &S, int T)
+{
+    long k = 0;
+    for (int h = S.height - 1; h > 0; h--)
+        k = k * (STREE_B + 1) + streeRankScalar(S.key + S.off[h] + k, T) * STREE_B;
+    return min(k + streeRankScalar(S.key + k, T), S.n);
+}
+
+#if defined(__SSE2__)
+__attribute__((target("sse4.2,popcnt"))) static inline unsigned streeRankSse(const int *y, int T)
+{
+    __m128i x = _mm_set1_epi32(T);
+    unsigned r = 0;
+    for (int i = 0; i < STREE_B; i += 4)
+        r += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, _mm_load_si128((const __m128i *)(y + i))))));
+    return r;
+}
+
+__attribute__((target("sse4.2,popcnt"))) static long streeLowerBoundSse(const STree &S, int T)
+{
+    long k = 0;
+    for (int h = S.height - 1; h > 0; h--)
+        k = k * (STREE_B + 1) + streeRankSse(S.key + S.off[h] + k, T) * STREE_B;
+    return min(k + streeRankSse(S.key + k, T), S.n);
+}
+
+__attribute__((target("avx2,popcnt"))) static inline unsigned streeRankAvx2(const int *y, int T)
+{
+    __m256i x = _mm256_set1_epi32(T);
+    unsigned r = 0;
+    for (int i = 0; i < STREE_B; i += 8)
+        r += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i *)(y + i))))));
+    return r;
+}
+
+__attribute__((target("avx2,popcnt"))) static long streeLowerBoundAvx2(const STree &S, int T)
+{
+    long k = 0;
+    for (int h = S.height - 1; h > 0; h--)
+        k = k * (STREE_B + 1) + streeRankAvx2(S.key + S.off[h] + k, T) * STREE_B;
+    return min(k + streeRankAvx2(S.key + k, T), S.n);
+}
+
+__attribute__((target("avx512f,popcnt"))) static inline unsigned streeRankAvx512(const int *y, int T)
+{
+    return __builtin_popcount(_mm512_cmpgt_epi32_mask(_mm512_set1_epi32(T), _mm512_load_si512(y)));
+}
+
+__attribute__((target("avx512f,popcnt"))) static long streeLowerBoundAvx512(const STree &S, int T)
+{
+    long k = 0;
+    for (int h = S.height - 1; h > 0; h--)
+        k = k * (STREE_B + 1) + streeRankAvx512(S.key + S.off[h] + k, T) * STREE_B;
+    return min(k + streeRankAvx512(S.key + k, T), S.n);
+}
+#endif
+
+static long (*streeDescent)(const STree &S, int T) = streeLowerBoundScalar;
+
+/* First index with key >= T, S.n if none */
+long STreeLowerBound(const STree &S, int T)
+{
+    return streeDescent(S, T);
+}
+
+int STreeSearch(const STree &S, int T)
+{
+    long i = STreeLowerBound(S, T);
+    return (i < S.n && S.key[i] == T) ? (int)i : -1;
+}
+
+/* 11. SIMD scans
+ * SequenceSearch and the last phase of JumpSearch compare one key per step
+ * and branch on each. The kernels below compare a whole vector of keys per
+ * instruction (4 with SSE4.2, 8 with AVX2, 16 with AVX-512) and branch once
+ * per vector. Which set runs is picked at startup from the CPU (cpuid), so
+ * one binary serves every machine; -s forces a narrower one.
+ *   firstEq   - index of the first key == T, or -1 (any order)
+ *   countEq   - number of keys == T (any order)
+ *   countLess - number of keys < T; in a sorted range, its lower bound
+ */
+struct ScanKernels
+{
+    const char *isa;
+    int (*firstEq)(const int A[], int n, int T);
+    long (*countEq)(const int A[], long n, int T);
+    int (*countLess)(const int A[], int n, int T);
+    long (*streeLowerBound)(const STree &S, int T); // Section 10's descent
+};
+
+static int firstEqScalar(const int A[], int n, int T)
 {
     for (int i = 0; i < n; i++)
         if (A[i] == T)
@@ -29,251 +256,636 @@ int SequenceSearch(int A[], int n, int T)
     return -1;
 }
 
-/* 2. BinarySearch
- * Binary search works on sorted arrays. Binary search begins by comparing
- * an element in the middle of the array with the target value. If the target
- * value matches the element, its position in the array is returned. 
- * If the target value is less than the element, the search continues in the
- * lower half of the array. If the target value is greater than the element, 
- * the search continues in the upper half of the array. By doing this,
- * the algorithm eliminates the half in which the target value cannot lie 
- * in each iteration.
- * ASL = log(n+1), Average Performance: O(log n), Space complexity: O(1)
- */
-int BinarySearch(int A[], int low, int high, int T)
+static long countEqScalar(const int A[], long n, int T)
+{
+    long c = 0;
+    for (long i = 0; i < n; i++)
+        c += A[i] == T;
+    return c;
+}
+
+static int countLessScalar(const int A[], int n, int T)
+{
+    int c = 0;
+    for (int i = 0; i < n; i++)
+        c += A[i] < T;
+    return c;
+}
+
+#if defined(__SSE2__)
+__attribute__((target("sse4.2"))) static int firstEqSse(const int A[], int n, int T)
 {
-    int L = low, R = high - 1, m;
-    while (L <= R)
+    __m128i x = _mm_set1_epi32(T);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
     {
-        m = (L + R) / 2;
-        if (A[m] < T)
-            L = m + 1;
-        else if (A[m] > T)
-            R = m - 1;
-        else
-            return m;
+        int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, _mm_loadu_si128((const __m128i *)(A + i)))));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    int r = firstEqScalar(A + i, n - i, T);
+    return r < 0 ? -1 : i + r;
+}
+
+__attribute__((target("sse4.2,popcnt"))) static long countEqSse(const int A[], long n, int T)
+{
+    __m128i x = _mm_set1_epi32(T), c = _mm_setzero_si128();
+    long i = 0;
+    for (; i + 4 <= n; i += 4) // Lanes count down by -1 per match
+        c = _mm_add_epi32(c, _mm_cmpeq_epi32(x, _mm_loadu_si128((const __m128i *)(A + i))));
+    alignas(16) int v[4];
+    _mm_store_si128((__m128i *)v, c);
+    return -(long)v[0] - v[1] - v[2] - v[3] + countEqScalar(A + i, n - i, T);
+}
+
+__attribute__((target("sse4.2,popcnt"))) static int countLessSse(const int A[], int n, int T)
+{
+    __m128i x = _mm_set1_epi32(T);
+    int i = 0, c = 0;
+    for (; i + 4 <= n; i += 4)
+        c += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, _mm_loadu_si128((const __m128i *)(A + i))))));
+    return c + countLessScalar(A + i, n - i, T);
+}
+
+__attribute__((target("avx2"))) static int firstEqAvx2(const int A[], int n, int T)
+{
+    __m256i x = _mm256_set1_epi32(T);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, _mm256_loadu_si256((const __m256i *)(A + i)))));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    int r = firstEqScalar(A + i, n - i, T);
+    return r < 0 ? -1 : i + r;
+}
+
+__attribute__((target("avx2"))) static long countEqAvx2(const int A[], long n, int T)
+{
+    __m256i x = _mm256_set1_epi32(T), c = _mm256_setzero_si256();
+    long i = 0;
+    for (; i + 8 <= n; i += 8) // Lanes count down by -1 per match
+        c = _mm256_add_epi32(c, _mm256_cmpeq_epi32(x, _mm256_loadu_si256((const __m256i *)(A + i))));
+    alignas(32) int v[8];
+    _mm256_store_si256((__m256i *)v, c);
+    long r = 0;
+    for (int j = 0; j < 8; j++)
+        r -= v[j];
+    return r + countEqScalar(A + i, n - i, T);
+}
+
+__attribute__((target("avx2,popcnt"))) static int countLessAvx2(const int A[], int n, int T)
+{
+    __m256i x = _mm256_set1_epi32(T);
+    int i = 0, c = 0;
+    for (; i + 8 <= n; i += 8)
+        c += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, _mm256_loadu_si256((const __m256i *)(A + i))))));
+    return c + countLessScalar(A + i, n - i, T);
+}
+
+__attribute__((target("avx512f"))) static int firstEqAvx512(const int A[], int n, int T)
+{
+    __m512i x = _mm512_set1_epi32(T);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __mmask16 m = _mm512_cmpeq_epi32_mask(x, _mm512_loadu_si512(A + i));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    if (i < n) // Masked tail, no scalar loop
+    {
+        __mmask16 m = _mm512_mask_cmpeq_epi32_mask((1u << (n - i)) - 1, x, _mm512_maskz_loadu_epi32((1u << (n - i)) - 1, A + i));
+        if (m)
+            return i + __builtin_ctz(m);
     }
     return -1;
 }
 
-/* 3. Interpolation Search
- * The Interpolation Search is an improvement over Binary Search for instances,
- * where the values in a sorted array are uniformly distributed. 
- * Binary Search always goes to the middle element to check. On the other hand, 
- * interpolation search may go to different locations according to the value 
- * of the key being searched. For example, if the value of the key is closer
- * to the last element, interpolation search is likely to start search 
- * toward the end side.
- * O(log log n)
- */
-int InterpolationSearch(int A[], int n, int T)
+__attribute__((target("avx512f"))) static long countEqAvx512(const int A[], long n, int T)
+{
+    __m512i x = _mm512_set1_epi32(T), c = _mm512_setzero_si512(), one = _mm512_set1_epi32(1);
+    long i = 0;
+    for (; i + 16 <= n; i += 16)
+        c = _mm512_mask_add_epi32(c, _mm512_cmpeq_epi32_mask(x, _mm512_loadu_si512(A + i)), c, one);
+    alignas(64) int v[16];
+    _mm512_store_si512(v, c);
+    long r = 0;
+    for (int j = 0; j < 16; j++)
+        r += v[j];
+    return r + countEqScalar(A + i, n - i, T);
+}
+
+__attribute__((target("avx512f,popcnt"))) static int countLessAvx512(const int A[], int n, int T)
 {
-    // Find indexes of two corners
-    int lo = 0, hi = (n - 1);
+    __m512i x = _mm512_set1_epi32(T);
+    int i = 0, c = 0;
+    for (; i + 16 <= n; i += 16)
+        c += __builtin_popcount(_mm512_cmpgt_epi32_mask(x, _mm512_loadu_si512(A + i)));
+    if (i < n)
+    {
+        __mmask16 k = (1u << (n - i)) - 1;
+        c += __builtin_popcount(_mm512_mask_cmpgt_epi32_mask(k, x, _mm512_maskz_loadu_epi32(k, A + i)));
+    }
+    return c;
+}
+#endif
 
-    // Since array is sorted, an element present
-    // in array must be in range defined by corner
-    while (lo <= hi && T >= A[lo] && T <= A[hi])
+const ScanKernels SCAN_KERNELS[] = {
+#if defined(__SSE2__)
+    {"avx512", firstEqAvx512, countEqAvx512, countLessAvx512, streeLowerBoundAvx512},
+    {"avx2", firstEqAvx2, countEqAvx2, countLessAvx2, streeLowerBoundAvx2},
+    {"sse4.2", firstEqSse, countEqSse, countLessSse, streeLowerBoundSse},
+#endif
+    {"scalar", firstEqScalar, countEqScalar, countLessScalar, streeLowerBoundScalar}};
+
+ScanKernels SCAN = SCAN_KERNELS[sizeof(SCAN_KERNELS) / sizeof(SCAN_KERNELS[0]) - 1];
+
+/* Widest kernels both the CPU and the -s cap allow */
+void SelectScanKernels(const string &cap)
+{
+    bool capped = !cap.empty();
+    for (const ScanKernels &k : SCAN_KERNELS)
     {
-        if (lo == hi)
+        string isa = k.isa;
+        bool ok = true;
+#if defined(__SSE2__)
+        __builtin_cpu_init();
+        if (isa == "avx512")
+            ok = __builtin_cpu_supports("avx512f");
+        else if (isa == "avx2")
+            ok = __builtin_cpu_supports("avx2");
+        else if (isa == "sse4.2")
+            ok = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#endif
+        if (capped && isa != cap)
+            continue;
+        if (ok)
         {
-            if (A[lo] == T)
-                return lo;
-            return -1;
+            SCAN = k;
+            streeDescent = k.streeLowerBound;
+            return;
         }
-        // Probing the position with keeping
-        // uniform distribution in mind.
-        int pos = lo + (((double)(hi - lo) /
-                         (A[hi] - A[lo])) *
-                        (T - A[lo]));
+        if (capped)
+            throw invalid_argument("CPU lacks " + cap);
+    }
+    throw invalid_argument("Unknown SIMD set " + cap);
+}
 
-        // Condition of target found
-        if (A[pos] == T)
-            return pos;
+/* The kernels are for int keys; other keys take the scalar searches */
+template <class Key, class Less = less<Key>>
+int SequenceSearchSimd(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    return SequenceSearch(A, n, T, lt);
+}
+
+template <class Key, class Less = less<Key>>
+int JumpSearchSimd(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    return JumpSearch(A, n, T, lt);
+}
 
-        // If x is larger, x is in upper part
-        if (A[pos] < T)
-            lo = pos + 1;
+int SequenceSearchSimd(const int A[], int n, int T)
+{
+    return SCAN.firstEq(A, n, T);
+}
 
-        // If x is smaller, x is in the lower part
-        else
-            hi = pos - 1;
+/* JumpSearch, with the walk through the last block done by countLess */
+int JumpSearchSimd(const int A[], int n, int T)
+{
+    if (n == 0)
+        return -1;
+    int step = sqrt(n);
+    int prev = 0;
+    while (A[min(step, n) - 1] < T)
+    {
+        prev = step;
+        step += sqrt(n);
+        if (prev >= n)
+            return -1;
     }
-    return -1;
+    int i = prev + SCAN.countLess(A + prev, min(step, n) - prev, T);
+    return (i < n && A[i] == T) ? i : -1;
 }
 
-/* 4. FibonacciSearch
- * Fibonacci Search is a comparison-based technique that uses Fibonacci 
- * numbers to search an element in a sorted array.
- * O(log n)
+/* 14. LearnedSearch
+ * A learned index replaces the search with a model of the key -> position
+ * map, here a PGM-style index: piecewise-linear segments, each guaranteed
+ * to predict the lower bound of every key it covers to within eps slots.
+ * Segments are fitted greedily (shrinking cone): a segment starts at a
+ * point and keeps the range of slopes that predicts every further point
+ * to +-eps; when the range empties a new segment starts. Upper levels fit
+ * the first keys of the level below in the same way, down from a single
+ * root segment, so a lookup is one prediction per level plus a scan of
+ * 2 eps + 3 keys at the bottom. Unlike InterpolationSearch, which assumes
+ * one straight line for the whole array, this only needs the keys to be
+ * locally linear, so skewed data just costs more segments.
+ * O(log_eps segments) per lookup, Space: O(segments).
  */
-int FibonacciSearch(int A[], int n, int T)
+struct Segment
 {
-    /* Initialize fibnacci numbers */
-    int fibMMm2 = 0;              // (m-2)'th Fibonacci No.
-    int fibMMm1 = 1;              // (m-1)'th Fibonacci No.
-    int fibM = fibMMm2 + fibMMm1; // m'th Fibonacci
+    long key;     // First key covered
+    double slope; // Positions per key
+    long pos;     // Position of key
+};
 
-    /* fibM is going to store the smallest Fibonacci
-       Number greater than or equal to n */
-    while (fibM < n)
+struct PGMIndex
+{
+    vector<vector<Segment>> level; // level[0] covers arr, back() is the root
+    long n;                        // Keys indexed
+    int eps;                       // Error bound of level[0]
+};
+
+PGMIndex pgm = {{}, 0, 0}; // Learned index over arr, if built
+
+/* Cover points (x[i], y[i]) (x increasing) with segments within eps */
+static void pgmFit(const vector<long> &x, const vector<long> &y, int eps, vector<Segment> &out)
+{
+    for (size_t i = 0, j; i < x.size(); i = j)
     {
-        fibMMm2 = fibMMm1;
-        fibMMm1 = fibM;
-        fibM = fibMMm2 + fibMMm1;
+        double lo = 0, hi = INFINITY;
+        for (j = i + 1; j < x.size(); j++)
+        {
+            double dx = x[j] - x[i];
+            double l = (y[j] - eps - y[i]) / dx, h = (y[j] + eps - y[i]) / dx;
+            if (l > hi || h < lo)
+                break;
+            lo = max(lo, l);
+            hi = min(hi, h);
+        }
+        out.push_back({x[i], j == i + 1 ? 0 : (lo + hi) / 2, y[i]});
     }
+}
 
-    // Marks the eliminated range from front
-    int offset = -1;
+/* Prediction of segment s of L, capped at where the next segment starts:
+ * past its last point a segment only extrapolates */
+static inline long pgmPredict(const vector<Segment> &L, long s, int T, long n)
+{
+    long p = L[s].pos + (long)(L[s].slope * ((double)T - L[s].key));
+    return min(max(p, 0L), s + 1 < (long)L.size() ? L[s + 1].pos : n);
+}
 
-    /* while there are elements to be inspected. Note that
-       we compare arr[fibMm2] with x. When fibM becomes 1,
-       fibMm2 becomes 0 */
-    while (fibM > 1)
+/* Points are every distinct key at its first index and, where the next
+ * integer is absent, key+1 at the next key's first index: the lower bound
+ * of any int query is then bracketed by two fitted points. */
+void BuildPGM(const int A[], long n, int eps, PGMIndex &P)
+{
+    vector<long> x, y;
+    for (long i = 0, j; i < n; i = j)
     {
-        // Check if fibMm2 is a valid location
-        int i = min(offset + fibMMm2, n - 1);
-
-        /* If T is greater than the value at index fibMm2,
-           cut the subarray array from offset to i */
-        if (A[i] < T)
+        for (j = i; j < n && A[j] == A[i]; j++)
+            ;
+        x.push_back(A[i]);
+        y.push_back(i);
+        if (j == n || A[j] != A[i] + 1)
         {
-            fibM = fibMMm1;
-            fibMMm1 = fibMMm2;
-            fibMMm2 = fibM - fibMMm1;
-            offset = i;
+            x.push_back((long)A[i] + 1);
+            y.push_back(j);
         }
+    }
+    P.n = n;
+    P.eps = eps;
+    P.level.assign(1, vector<Segment>());
+    pgmFit(x, y, eps, P.level[0]);
+    while (P.level.back().size() > 1)
+    {
+        const vector<Segment> &L = P.level.back();
+        x.resize(L.size());
+        y.resize(L.size());
+        for (size_t i = 0; i < L.size(); i++)
+            x[i] = L[i].key, y[i] = i;
+        vector<Segment> up;
+        pgmFit(x, y, PGM_EPS_REC, up);
+        P.level.push_back(move(up));
+    }
+}
+
+long PGMBytes(const PGMIndex &P)
+{
+    long b = 0;
+    for (const vector<Segment> &L : P.level)
+        b += L.size() * sizeof(Segment);
+    return b;
+}
 
-        /* If T is greater than the value at index fibMm2,
-           cut the subarray after i+1  */
-        else if (A[i] > T)
+/* First index with A[i] >= T, P.n if none */
+long LearnedLowerBound(const PGMIndex &P, const int A[], int T)
+{
+    // Walk down: the segment covering T is the last whose key <= T
+    long s = 0;
+    for (size_t l = P.level.size() - 1; l > 0; l--)
+    {
+        const vector<Segment> &L = P.level[l - 1];
+        long last = L.size() - 1;
+        long p = pgmPredict(P.level[l], s, T, last);
+        long lo = max(0L, p - PGM_EPS_REC - 2), hi = min(last, p + PGM_EPS_REC + 1);
+        while (lo < hi)
         {
-            fibM = fibMMm2;
-            fibMMm1 = fibMMm1 - fibMMm2;
-            fibMMm2 = fibM - fibMMm1;
+            long m = (lo + hi + 1) / 2;
+            if (L[m].key <= T)
+                lo = m;
+            else
+                hi = m - 1;
         }
-
-        /* element found. return index */
-        else
-            return i;
+        s = lo;
     }
 
-    /* comparing the last element with x */
-    if (fibMMm1 && A[offset + 1] == T)
-        return offset + 1;
+    // Last mile: the lower bound is within eps (+1 for rounding)
+    long p = pgmPredict(P.level[0], s, T, P.n);
+    long lo = max(0L, p - P.eps - 1), hi = min(P.n, p + P.eps + 2);
+    return lo + SCAN.countLess(A + lo, hi - lo, T);
+}
 
-    /*element not found. return -1 */
-    return -1;
+int LearnedSearch(const PGMIndex &P, const int A[], int T)
+{
+    long i = LearnedLowerBound(P, A, T);
+    return (i < P.n && A[i] == T) ? (int)i : -1;
 }
 
-/*5. ExponentialSearch
- * Exponential search allows for searching through a sorted, unbounded list 
- * for a specified input value (the search "key"). The algorithm consists of 
- * two stages. The first stage determines a range in which the search key 
- * would reside if it were in the list. In the second stage, a binary search 
- * is performed on this range. In the first stage, assuming that the list 
- * is sorted in ascending order, the algorithm looks for the first exponent, 
- * j, where the value 2j is greater than the search key. This value, 2j 
- * becomes the upper bound for the binary search with the previous power of 
- * 2, 2j - 1, being the lower bound for the binary search.
- * Average performance: O(log n), Space complexity: O(1).
+/* 15. Bounds over the int indexes
+ * Eytzinger, the S-tree and the learned index each answer only lower_bound
+ * on their own layout (LB below is any callable T -> index, n if none).
+ * Their keys are ints, so upper_bound(T) is lower_bound(T + 1), and the
+ * rest of SearchLib.h's bounds follow from that. Sorted arrays of any key
+ * type use LowerBound / UpperBound / EqualRange / RangeCount directly.
  */
-int ExponentialSearch(int A[], int n, int T)
+template <class LB>
+long UpperBoundBy(LB lowerBound, long n, int T)
 {
-    if (n == 0)
-        return -1;
-    int bound = 1;
-    while (bound < n && A[bound] < T)
-    {
-        bound *= 2;
-    }
-    return BinarySearch(A, bound / 2, min(bound + 1, n), T);
+    return T == INT_MAX ? n : lowerBound(T + 1);
 }
 
-/* 6. TernarySearch
- * Ternary search is a divide and conquer algorithm that can be used to find 
- * an element in an array. It is similar to binary search where we divide 
- * the array into two parts but in this algorithm, we divide the given array 
- * into three parts and determine which has the key (searched element). 
- * We can divide the array into three parts by taking m1 and m2 which 
- * can be calculated as shown below. Initially, l and r will be equal to 0 
- * and n-1 respectively, where n is the length of the array. 
- * O(log3 n)
- */
-int TernarySearch(int A[], int l, int r, int T)
-{
-    int m1 = 0, m2 = 0;
-    if (l <= r)
-    {
-        m1 = l + (r - l) / 3;
-        m2 = r - (r - l) / 3;
-        if (A[m1] == T)
-            return m1;
-        if (A[m2] == T)
-            return m2;
-        if (T < A[m1])
-            return TernarySearch(A, l, m1 - 1, T);
-        else if (T > A[m2])
-            return TernarySearch(A, m2 + 1, r, T);
-        else
-            return TernarySearch(A, m1 + 1, m2 - 1, T);
-    }
-    return -1;
+template <class LB>
+pair<long, long> EqualRangeBy(LB lowerBound, long n, int T)
+{
+    return make_pair(lowerBound(T), UpperBoundBy(lowerBound, n, T));
 }
 
-/*7. JumpSearch
- * Jump Search is a searching algorithm for sorted arrays. The basic idea is
- * to check fewer elements (than linear search) by jumping ahead by fixed 
- * steps or skipping some elements in place of searching all elements.
- * O(√n), O(1)
+template <class LB>
+long RangeCountBy(LB lowerBound, long n, int lo, int hi)
+{
+    return lo > hi ? 0 : UpperBoundBy(lowerBound, n, hi) - lowerBound(lo);
+}
+
+/* 16. HashSearch
+ * For point lookups a hash index answers in O(1) probes. This one follows
+ * the SwissTable design: open addressing over groups of HASH_GROUP slots,
+ * with a separate array of one control byte per slot holding HASH_EMPTY or
+ * 7 bits of the key's hash (H2). A lookup hashes once, and for each group on
+ * its probe sequence compares all 16 control bytes against H2 in one SIMD
+ * compare; only slots whose byte matches are read, and a group with an
+ * empty slot ends the search. Each slot holds a distinct key and its first
+ * index in arr. Load factor at most HASH_LOAD.
+ * O(1) expected, Space: about (1 + 8) bytes / HASH_LOAD per distinct key.
  */
-int JumpSearch(int A[], int n, int T)
+struct HashSlot
 {
-    int step = sqrt(n);
-    int prev = 0;
-    while (A[min(step, n) - 1] < T)
+    int key; // Distinct key of arr
+    int idx; // Its first index in arr
+};
+
+struct HashIndex
+{
+    int8_t *ctrl;   // Per slot: HASH_EMPTY or H2 of its key
+    HashSlot *slot; // Per slot: the entry
+    long groups;    // A power of two
+};
+
+HashIndex hidx = {NULL, NULL, 0}; // Hash index over arr, if built
+
+static inline uint64_t mix64(uint64_t h) // splitmix64 finalizer
+{
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static inline long fastRange(uint64_t h, long n) // h scaled to [0, n)
+{
+    return (long)(((unsigned __int128)h * (uint64_t)n) >> 64);
+}
+
+/* Each distinct key of A (sorted) with its first index */
+template <class F>
+static void forDistinct(const int A[], long n, F f)
+{
+    for (long i = 0; i < n; i++)
+        if (i == 0 || A[i] != A[i - 1])
+            f(A[i], i);
+}
+
+static inline unsigned hashMatch(const int8_t *g, int8_t b) // Bit j: g[j] == b
+{
+#if defined(__SSE2__)
+    __m128i c = _mm_load_si128((const __m128i *)g);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(b)));
+#else
+    unsigned m = 0;
+    for (int j = 0; j < HASH_GROUP; j++)
+        m |= (unsigned)(g[j] == b) << j;
+    return m;
+#endif
+}
+
+void BuildHashIndex(const int A[], long n, HashIndex &H)
+{
+    long distinct = 0;
+    forDistinct(A, n, [&](int, long) { distinct++; });
+    for (H.groups = 1; H.groups * HASH_GROUP * HASH_LOAD < distinct + 1; H.groups *= 2)
+        ;
+    long slots = H.groups * HASH_GROUP;
+    // aligned_alloc wants a multiple of the alignment: 1 or 2 groups of
+    // control bytes are less than a line
+    H.ctrl = (int8_t *)aligned_alloc(64, (slots + 63) / 64 * 64);
+    H.slot = (HashSlot *)aligned_alloc(64, (slots * sizeof(HashSlot) + 63) / 64 * 64);
+    if (H.ctrl == NULL || H.slot == NULL)
+        throw bad_alloc();
+    memset(H.ctrl, HASH_EMPTY, slots);
+
+    // Triangular probing over a power of two of groups visits every group
+    forDistinct(A, n, [&](int k, long i) {
+        uint64_t h = mix64((uint32_t)k);
+        for (long g = (h >> 7) & (H.groups - 1), step = 1;; g = (g + step++) & (H.groups - 1))
+        {
+            unsigned m = hashMatch(H.ctrl + g * HASH_GROUP, HASH_EMPTY);
+            if (m)
+            {
+                long j = g * HASH_GROUP + __builtin_ctz(m);
+                H.ctrl[j] = h & 0x7f;
+                H.slot[j] = {k, (int)i};
+                break;
+            }
+        }
+    });
+}
+
+long HashBytes(const HashIndex &H)
+{
+    return H.groups * HASH_GROUP * (1 + sizeof(HashSlot));
+}
+
+int HashSearch(const HashIndex &H, int T)
+{
+    uint64_t h = mix64((uint32_t)T);
+    for (long g = (h >> 7) & (H.groups - 1), step = 1;; g = (g + step++) & (H.groups - 1))
     {
-        prev = step;
-        step += sqrt(n);
-        if (prev >= n)
+        const int8_t *c = H.ctrl + g * HASH_GROUP;
+        for (unsigned m = hashMatch(c, h & 0x7f); m; m &= m - 1)
+        {
+            const HashSlot &e = H.slot[g * HASH_GROUP + __builtin_ctz(m)];
+            if (e.key == T)
+                return e.idx;
+        }
+        if (hashMatch(c, HASH_EMPTY))
             return -1;
     }
+}
+
+/* 17. PerfectHashSearch
+ * The dictionary is static, so its distinct keys can get a minimal perfect
+ * hash: a function onto [0, u) with no collisions, for u distinct keys.
+ * Built by hash-and-displace: keys are split into u / MPH_BUCKET buckets,
+ * and buckets, largest first, each search for a pilot (seed) that sends all
+ * their keys to free slots. A lookup is two hashes, a pilot load and one
+ * slot load; the slot holds only the index into arr, and arr[index] == T
+ * rejects keys outside the dictionary.
+ * O(1) worst case lookup, Space: 4 bytes per slot + 4 per bucket.
+ */
+struct PerfectHash
+{
+    vector<uint32_t> pilot; // Per bucket: seed that places its keys
+    vector<int> idx;        // Per slot: first index in arr of its key
+};
+
+PerfectHash mph; // Minimal perfect hash over arr, if built
+
+static inline long mphBucket(int k, long buckets)
+{
+    return fastRange(mix64((uint32_t)k ^ 0x5bd1e9955bd1e995ULL), buckets);
+}
+
+static inline long mphSlot(int k, uint32_t pilot, long slots)
+{
+    return fastRange(mix64((uint32_t)k + ((uint64_t)pilot << 32) + pilot * 0x9e3779b97f4a7c15ULL), slots);
+}
+
+void BuildPerfectHash(const int A[], long n, PerfectHash &P)
+{
+    vector<int> keys;
+    vector<int> first;
+    forDistinct(A, n, [&](int k, long i) {
+        keys.push_back(k);
+        first.push_back((int)i);
+    });
+    long u = keys.size(), nb = max(1L, u / MPH_BUCKET);
 
-    while (A[prev] < T)
+    // Keys grouped by bucket (counting sort), buckets ordered largest first
+    vector<long> start(nb + 1, 0), order(u);
+    for (int k : keys)
+        start[mphBucket(k, nb) + 1]++;
+    for (long b = 0; b < nb; b++)
+        start[b + 1] += start[b];
+    vector<long> fill(start.begin(), start.end() - 1);
+    for (long i = 0; i < u; i++)
+        order[fill[mphBucket(keys[i], nb)]++] = i;
+    vector<long> byLoad(nb);
+    for (long b = 0; b < nb; b++)
+        byLoad[b] = b;
+    stable_sort(byLoad.begin(), byLoad.end(), [&](long a, long b) { return start[a + 1] - start[a] > start[b + 1] - start[b]; });
+
+    P.pilot.assign(nb, 0);
+    P.idx.assign(max(1L, u), -1);
+    vector<char> taken(u, 0);
+    vector<long> pos;
+    for (long b : byLoad)
     {
-        prev++;
-        if (prev == min(step, n))
-            return -1;
+        long size = start[b + 1] - start[b];
+        if (size == 0)
+            break;
+        for (uint32_t p = 0;; p++)
+        {
+            if (p == UINT32_MAX)
+                throw runtime_error("No pilot for a perfect hash bucket");
+            pos.clear();
+            bool ok = true;
+            for (long j = start[b]; j < start[b + 1] && ok; j++)
+            {
+                long s = mphSlot(keys[order[j]], p, u);
+                ok = !taken[s] && find(pos.begin(), pos.end(), s) == pos.end();
+                pos.push_back(s);
+            }
+            if (!ok)
+                continue;
+            for (long j = 0; j < size; j++)
+            {
+                taken[pos[j]] = 1;
+                P.idx[pos[j]] = first[order[start[b] + j]];
+            }
+            P.pilot[b] = p;
+            break;
+        }
     }
+}
 
-    if (A[prev] == T)
-        return prev;
+long PerfectHashBytes(const PerfectHash &P)
+{
+    return P.pilot.size() * sizeof(uint32_t) + P.idx.size() * sizeof(int);
+}
 
-    return -1;
+int PerfectHashSearch(const PerfectHash &P, const int A[], int T)
+{
+    long b = mphBucket(T, P.pilot.size());
+    int i = P.idx[mphSlot(T, P.pilot[b], P.idx.size())];
+    return (i >= 0 && A[i] == T) ? i : -1;
 }
 
-/* 
- * bucketSort() - Non-Comparision Sort algorithm, bucket sorting
- * O(n+k), O(n+k), Stable
+/*
+ * radixSort() - Non-Comparision Sort algorithm, LSD radix sorting
+ * 11-bit digits, so 3 stable scatter passes through one scratch array, with
+ * the counts of all digits taken in one read and constant digits skipped.
+ * Replaces a counting sort whose max-sized bucket array lived on the stack.
+ * O(3n), O(n + 2^11), Stable
  */
-void bucketSort(int A[], int n, int max)
+static inline unsigned radixKey(int x) // Signed order as unsigned order
 {
-    int i, j;
-    int buckets[max];
+    return (unsigned)x ^ 0x80000000u;
+}
 
-    // Initiate all values to 0 in buckets
-    memset(buckets, 0, max * sizeof(int));
+void radixSort(int A[], int n)
+{
+    const int BITS = 11, RADIX = 1 << BITS, MASK = RADIX - 1, PASSES = 3;
+    if (n < 2)
+        return;
 
-    // 1. counting
-    for (i = 0; i < n; i++)
-        buckets[A[i]]++;
+    // 1. counting, all digits at once
+    vector<int> hist(PASSES * RADIX, 0), pos(RADIX);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned k = radixKey(A[i]);
+        for (int p = 0; p < PASSES; p++)
+            hist[p * RADIX + ((k >> (p * BITS)) & MASK)]++;
+    }
 
-    // 2. sorting
-    for (i = 0, j = 0; i < max; i++)
+    // 2. scattering, one digit per pass
+    vector<int> buf(n);
+    int *src = A, *dst = buf.data();
+    for (int p = 0; p < PASSES; p++)
     {
-        while ((buckets[i]--) > 0)
-            A[j++] = i;
+        int shift = p * BITS, *h = &hist[p * RADIX];
+        if (h[(radixKey(src[0]) >> shift) & MASK] == n)
+            continue;
+        for (int d = 0, sum = 0; d < RADIX; d++)
+        {
+            pos[d] = sum;
+            sum += h[d];
+        }
+        for (int i = 0; i < n; i++)
+            dst[pos[(radixKey(src[i]) >> shift) & MASK]++] = src[i];
+        swap(src, dst);
     }
+    if (src != A)
+        memcpy(A, src, n * sizeof(int));
 }
 
 /*
@@ -281,11 +893,19 @@ void bucketSort(int A[], int n, int max)
  */
 int GenKeyNumber()
 {
-    random_device rd;                           //obtain a random number from hardware
-    mt19937 gen(rd());                          //seed the generator
-    uniform_int_distribution<> distr(MIN, MAX); //define the range
+    static random_device rd;                           //obtain a random number from hardware
+    static mt19937 gen(rd());                          //seed the generator once
+    static uniform_int_distribution<> distr(MIN, MAX); //define the range
+    static lognormal_distribution<> logn(0.0, 2.0);    //skewed: long right tail
+    static uniform_real_distribution<> unit(0.0, 1.0);
 
     //assign the rand value to key number
+    if (DIST == "lognormal")
+        return MIN + (int)min<double>(MAX - MIN, logn(gen) * 1000);
+    if (DIST == "power") // Dense near MIN, sparse towards MAX
+        return MIN + (int)((MAX - MIN) * pow(unit(gen), 8));
+    if (DIST == "dups") // Every DUP_COPIES-th value, so long runs of each
+        return MIN + distr(gen) / DUP_COPIES * DUP_COPIES;
     return distr(gen);
 }
 
@@ -296,14 +916,220 @@ void BuildDataDictionary()
 
     // Assign values to array with random numbers
     auto t0 = chrono::high_resolution_clock::now(); //get start time
-    for (int i = MIN; i <= MAX; i++)
+    for (int i = MIN; i < MAX; i++)
         arr[i] = GenKeyNumber();                    //this forms a sorted serise of [MIN, MAX]
     auto t1 = chrono::high_resolution_clock::now(); //get start time
-    cout << "Building radom data set [" + to_string(MIN) + ", " + to_string(MAX) + "] ... " << chrono::duration_cast<chrono::microseconds>(t1 - t0).count() << " ms." << endl;
+    cout << "Building radom data set [" + to_string(MIN) + ", " + to_string(MAX) + "], " + DIST + " ... " << chrono::duration_cast<chrono::microseconds>(t1 - t0).count() << " ms." << endl;
     // Sort the array for future searching
-    bucketSort(arr, MAX, MAX + 1);
+    radixSort(arr, MAX);
     auto t2 = chrono::high_resolution_clock::now(); //get start time
-    cout << "Bucket Sorting for searching ... " << chrono::duration_cast<chrono::microseconds>(t2 - t1).count() << " ms." << endl;
+    cout << "Radix Sorting for searching ... " << chrono::duration_cast<chrono::microseconds>(t2 - t1).count() << " ms." << endl;
+}
+
+/*
+ * BuildIndexes() - The auxiliary indexes asked for and not already loaded.
+ */
+void BuildIndexes()
+{
+    if (EYTZINGER && eyt == NULL)
+    {
+        auto t2 = chrono::high_resolution_clock::now();
+        BuildEytzinger(arr, MAX, eyt, eytIdx);
+        auto t3 = chrono::high_resolution_clock::now();
+        cout << "Eytzinger layout ... " << chrono::duration_cast<chrono::microseconds>(t3 - t2).count() << " ms." << endl;
+    }
+    if (BTREE && stree.key == NULL)
+    {
+        auto t3 = chrono::high_resolution_clock::now();
+        BuildSTree(arr, MAX, stree);
+        auto t4 = chrono::high_resolution_clock::now();
+        cout << "S-tree index (" << stree.height << " layers) ... " << chrono::duration_cast<chrono::microseconds>(t4 - t3).count() << " ms." << endl;
+    }
+    if (PGM_EPS > 0)
+    {
+        auto t4 = chrono::high_resolution_clock::now();
+        BuildPGM(arr, MAX, PGM_EPS, pgm);
+        auto t5 = chrono::high_resolution_clock::now();
+        cout << "Learned index (eps " << PGM_EPS << ", " << pgm.level[0].size() << " segments, " << pgm.level.size()
+             << " levels, " << PGMBytes(pgm) << " bytes) ... " << chrono::duration_cast<chrono::microseconds>(t5 - t4).count() << " ms." << endl;
+    }
+    if (HASH)
+    {
+        auto t5 = chrono::high_resolution_clock::now();
+        BuildHashIndex(arr, MAX, hidx);
+        auto t6 = chrono::high_resolution_clock::now();
+        cout << "Hash index (" << HashBytes(hidx) << " bytes) ... " << chrono::duration_cast<chrono::microseconds>(t6 - t5).count() << " ms." << endl;
+        BuildPerfectHash(arr, MAX, mph);
+        auto t7 = chrono::high_resolution_clock::now();
+        cout << "Perfect hash (" << PerfectHashBytes(mph) << " bytes) ... " << chrono::duration_cast<chrono::microseconds>(t7 - t6).count() << " ms." << endl;
+    }
+}
+
+/*
+ * Saved dictionary: a header, then the sorted keys and any Eytzinger and
+ * S-tree copies, each at a page-aligned offset. Mapped read-only, the file
+ * is usable as is: no parsing, no copies, pages fault in on first touch
+ * (or all at open with MAP_POPULATE).
+ */
+struct DictHeader
+{
+    char magic[8];                  // DICT_MAGIC
+    int64_t n;                      // Keys
+    int32_t min, max;               // Key range
+    int64_t arr, eyt, eytIdx;       // Section offsets, 0 if absent
+    int64_t stree, streeSize;       // S-tree offset and ints
+    int32_t streeB, streeHeight;    // Node size and layers
+    int64_t streeOff[STREE_MAX_H];  // Layer starts
+};
+
+static void writeSection(int fd, int64_t &off, const void *p, size_t bytes)
+{
+    off = (off + PAGE - 1) / PAGE * PAGE;
+    for (size_t done = 0; done < bytes;)
+    {
+        ssize_t w = pwrite(fd, (const char *)p + done, bytes - done, off + done);
+        if (w <= 0)
+            throw runtime_error("Write failed: " + string(strerror(errno)));
+        done += w;
+    }
+}
+
+/* Sections, then the header */
+static void writeDictionary(int fd)
+{
+    DictHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DICT_MAGIC, sizeof(h.magic));
+    h.n = MAX;
+    h.min = MIN;
+    h.max = MAX;
+    int64_t end = sizeof(h);
+    h.arr = end;
+    writeSection(fd, h.arr, arr, MAX * sizeof(int));
+    end = h.arr + MAX * sizeof(int);
+    if (eyt != NULL)
+    {
+        size_t bytes = (MAX + 1) * sizeof(int);
+        h.eyt = end;
+        writeSection(fd, h.eyt, eyt, bytes);
+        h.eytIdx = h.eyt + bytes;
+        writeSection(fd, h.eytIdx, eytIdx, bytes);
+        end = h.eytIdx + bytes;
+    }
+    if (stree.key != NULL)
+    {
+        h.streeSize = stree.size;
+        h.streeB = STREE_B;
+        h.streeHeight = stree.height;
+        copy(stree.off, stree.off + STREE_MAX_H, h.streeOff);
+        h.stree = end;
+        writeSection(fd, h.stree, stree.key, stree.size * sizeof(int));
+        end = h.stree + stree.size * sizeof(int);
+    }
+    int64_t head = 0;
+    writeSection(fd, head, &h, sizeof(h));
+}
+
+/*
+ * Written to file.tmp, synced, then renamed over file: a crash leaves the
+ * old file or the new one, never a torn one, and a file that is mapped
+ * right now (-o and -w the same) keeps its old contents under the mapping.
+ */
+void SaveDictionary(const string &file)
+{
+    auto t0 = chrono::high_resolution_clock::now();
+    string tmp = file + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw runtime_error("Cannot create " + tmp + ": " + strerror(errno));
+    try
+    {
+        writeDictionary(fd);
+        if (fsync(fd) != 0)
+            throw runtime_error("Sync failed: " + string(strerror(errno)));
+    }
+    catch (...)
+    {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+    if (close(fd) != 0 || rename(tmp.c_str(), file.c_str()) != 0)
+    {
+        string err = strerror(errno);
+        unlink(tmp.c_str());
+        throw runtime_error("Cannot save " + file + ": " + err);
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    cout << "Saved dictionary to " << file << " ... " << chrono::duration_cast<chrono::microseconds>(t1 - t0).count() << " ms." << endl;
+}
+
+/* Drop the mapping's pages and the file's page cache: next touch reads disk */
+static void evictDictionary(int fd)
+{
+    madvise(MAPPED, MAPPED_BYTES, MADV_DONTNEED);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+int OpenDictionary(const string &file)
+{
+    auto t0 = chrono::high_resolution_clock::now();
+    int fd = open(file.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        throw runtime_error("Cannot open " + file + ": " + strerror(errno));
+    if (COLD)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    MAPPED_BYTES = st.st_size;
+    void *p = mmap(NULL, MAPPED_BYTES, PROT_READ, MAP_SHARED | (POPULATE ? MAP_POPULATE : 0), fd, 0);
+    if (p == MAP_FAILED)
+        throw runtime_error("Cannot map " + file + ": " + strerror(errno));
+    MAPPED = (char *)p;
+    if (HUGEPAGES)
+        madvise(MAPPED, MAPPED_BYTES, MADV_HUGEPAGE); // Needs THP for file pages
+
+    DictHeader h;
+    if (MAPPED_BYTES < sizeof(h) || memcmp(MAPPED, DICT_MAGIC, sizeof(h.magic)) != 0)
+        throw runtime_error(file + " is not a saved dictionary");
+    memcpy(&h, MAPPED, sizeof(h));
+
+    // Every section must be where the writer puts them and inside the file,
+    // so a damaged header is reported here and not as a fault later
+    auto inFile = [&](int64_t off, int64_t ints) {
+        return off >= (int64_t)sizeof(h) && off % PAGE == 0 && ints >= 0 &&
+               off <= (int64_t)MAPPED_BYTES && ints <= ((int64_t)MAPPED_BYTES - off) / (int64_t)sizeof(int);
+    };
+    bool ok = h.n > 0 && h.n < INT_MAX && h.min == MIN && inFile(h.arr, h.n);
+    if (ok && h.eyt != 0)
+        ok = inFile(h.eyt, h.n + 1) && inFile(h.eytIdx, h.n + 1);
+    STree shape;
+    bool hasSTree = ok && h.stree != 0 && h.streeB == STREE_B; // Else rebuilt if asked for
+    if (hasSTree)
+    {
+        streeShape(h.n, shape);
+        ok = h.streeHeight == shape.height && h.streeSize == shape.size && inFile(h.stree, h.streeSize) &&
+             equal(shape.off, shape.off + shape.height, h.streeOff);
+    }
+    if (!ok)
+        throw runtime_error(file + " is damaged");
+
+    MAX = h.n;
+    arr = (int *)(MAPPED + h.arr);
+    if (h.eyt != 0)
+    {
+        eyt = (int *)(MAPPED + h.eyt);
+        eytIdx = (int *)(MAPPED + h.eytIdx);
+    }
+    if (hasSTree)
+    {
+        stree = shape;
+        stree.key = (int *)(MAPPED + h.stree);
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    cout << "Opened " << file << " (" << MAX << " keys" << (eyt ? ", Eytzinger" : "") << (stree.key ? ", S-tree" : "")
+         << ", " << (MAPPED_BYTES >> 20) << " MB) ... " << chrono::duration_cast<chrono::microseconds>(t1 - t0).count() << " ms." << endl;
+    return fd;
 }
 
 /*
@@ -351,26 +1177,886 @@ void test()
     auto t7 = chrono::high_resolution_clock::now(); //get start time
     dispResult("7. Jump", index, t7 - t6);
 
+    cout << "   (scans: " << SCAN.isa << ")" << endl;
+    t7 = chrono::high_resolution_clock::now();
+    index = SequenceSearchSimd(arr, MAX, key);
+    auto t71 = chrono::high_resolution_clock::now();
+    dispResult("11. Sequence SIMD", index, t71 - t7);
+
+    index = JumpSearchSimd(arr, MAX - 1, key);
+    auto t72 = chrono::high_resolution_clock::now();
+    dispResult("12. Jump SIMD", index, t72 - t71);
+
+    long count = SCAN.countEq(arr, MAX, key);
+    auto t73 = chrono::high_resolution_clock::now();
+    cout << left << setw(20) << "13. Count SIMD" << " key(" << key << ") " << count << " matches, " << chrono::duration_cast<chrono::microseconds>(t73 - t72).count() << " ms." << endl;
+    t7 = t73;
+
+    auto t8 = t7;
+    if (eyt != NULL)
+    {
+        index = EytzingerSearch(eyt, eytIdx, MAX, key);
+        t8 = chrono::high_resolution_clock::now();
+        dispResult("9. Eytzinger", index, t8 - t7);
+    }
+    auto t9 = t8;
+    if (stree.key != NULL)
+    {
+        index = STreeSearch(stree, key);
+        t9 = chrono::high_resolution_clock::now();
+        dispResult("10. S-tree", index, t9 - t8);
+    }
+    if (!pgm.level.empty())
+    {
+        index = LearnedSearch(pgm, arr, key);
+        auto t10 = chrono::high_resolution_clock::now();
+        dispResult("14. Learned", index, t10 - t9);
+        t9 = t10;
+    }
+    if (hidx.ctrl != NULL)
+    {
+        index = HashSearch(hidx, key);
+        auto t10 = chrono::high_resolution_clock::now();
+        dispResult("16. Hash", index, t10 - t9);
+        index = PerfectHashSearch(mph, arr, key);
+        auto t11 = chrono::high_resolution_clock::now();
+        dispResult("17. Perfect hash", index, t11 - t10);
+        t9 = t11;
+    }
+
     cout << "//////////////////////////////////////////////////////////" << endl;
-    cout << left << setw(20) << "Total searching time: " << chrono::duration_cast<chrono::microseconds>(t7 - t0).count() << " ms." << endl;
+    cout << left << setw(20) << "Total searching time: " << chrono::duration_cast<chrono::microseconds>(t9 - t0).count() << " ms." << endl;
 }
 
-int main(int argc, char const *argv[])
+/*
+ * Display batch throughput, and whether every result names a matching
+ * index (or -1 exactly when the single-key search found nothing).
+ */
+static auto dispRate = [](string str, const vector<int> &K, const vector<int> &R, const vector<int> &ref, auto diffTime) {
+    bool ok = true;
+    for (size_t i = 0; i < K.size() && ok; i++)
+        ok = (R[i] == -1) ? ref[i] == -1 : (ref[i] != -1 && arr[R[i]] == K[i]);
+    double sec = chrono::duration<double>(diffTime).count();
+    cout << left << setw(20) << str << fixed << setprecision(2) << K.size() / sec / 1e6 << " Mkeys/s, "
+         << chrono::duration_cast<chrono::microseconds>(diffTime).count() << " us." << (ok ? "" : " MISMATCH") << endl;
+    cout.unsetf(ios::fixed);
+};
+
+void testBatch()
 {
+    mt19937 gen(random_device{}());
+    uniform_int_distribution<> distr(MIN, MAX);
+    vector<int> K(BATCH), R(BATCH), ref(BATCH);
+    for (int &k : K)
+        k = distr(gen);
+
+    cout << "Batched lookups of " << BATCH << " keys, " << GROUP << " in flight ..." << endl;
+    auto t0 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < BATCH; i++)
+        ref[i] = BinarySearch(arr, MIN, MAX, K[i]);
+    auto t1 = chrono::high_resolution_clock::now();
+    dispRate("2. Binary", K, ref, ref, t1 - t0);
+
+    BinarySearchBatch(arr, MAX, K.data(), BATCH, R.data());
+    auto t2 = chrono::high_resolution_clock::now();
+    dispRate("8. Binary batch", K, R, ref, t2 - t1);
+
+    for (int i = 0; i < BATCH; i++)
+        R[i] = InterpolationSearch(arr, MAX, K[i]);
+    auto t3 = chrono::high_resolution_clock::now();
+    dispRate("3. Interpolation", K, R, ref, t3 - t2);
+
+    InterpolationSearchBatch(arr, MAX, K.data(), BATCH, R.data());
+    auto t4 = chrono::high_resolution_clock::now();
+    dispRate("8. Interp. batch", K, R, ref, t4 - t3);
+
+    // Jump is O(sqrt n) a key: time it on a slice of the batch
+    int jumps = BATCH / JUMP_SLICE;
+    vector<int> KJ(K.begin(), K.begin() + jumps), RJ(jumps), refJ(ref.begin(), ref.begin() + jumps);
+    auto rows = [&](const char *single, const char *batched, const vector<int> &Q, vector<int> &S,
+                    const vector<int> &E, int (*one)(const int *, int, const int &, less<int>),
+                    void (*many)(const int *, int, const int *, int, int *, less<int>)) {
+        auto u0 = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < Q.size(); i++)
+            S[i] = one(arr, MAX, Q[i], less<int>());
+        auto u1 = chrono::high_resolution_clock::now();
+        dispRate(single, Q, S, E, u1 - u0);
+        many(arr, MAX, Q.data(), Q.size(), S.data(), less<int>());
+        auto u2 = chrono::high_resolution_clock::now();
+        dispRate(batched, Q, S, E, u2 - u1);
+    };
+    rows("5. Exponential", "8. Exp. batch", K, R, ref, ExponentialSearch<int>, ExponentialSearchBatch<int>);
+    rows("7. Jump", "8. Jump batch", KJ, RJ, refJ, JumpSearch<int>, JumpSearchBatch<int>);
+    t4 = chrono::high_resolution_clock::now();
+
+    if (eyt != NULL)
+    {
+        for (int i = 0; i < BATCH; i++)
+            R[i] = EytzingerSearch(eyt, eytIdx, MAX, K[i]);
+        auto t5 = chrono::high_resolution_clock::now();
+        dispRate("9. Eytzinger", K, R, ref, t5 - t4);
+    }
+    if (stree.key != NULL)
+    {
+        auto t5 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            R[i] = STreeSearch(stree, K[i]);
+        auto t6 = chrono::high_resolution_clock::now();
+        dispRate("10. S-tree", K, R, ref, t6 - t5);
+    }
+    if (!pgm.level.empty())
+    {
+        auto t6 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            R[i] = LearnedSearch(pgm, arr, K[i]);
+        auto t7 = chrono::high_resolution_clock::now();
+        dispRate("14. Learned", K, R, ref, t7 - t6);
+    }
+    if (hidx.ctrl != NULL)
+    {
+        auto t7 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            R[i] = HashSearch(hidx, K[i]);
+        auto t8 = chrono::high_resolution_clock::now();
+        dispRate("16. Hash", K, R, ref, t8 - t7);
+        for (int i = 0; i < BATCH; i++)
+            R[i] = PerfectHashSearch(mph, arr, K[i]);
+        auto t9 = chrono::high_resolution_clock::now();
+        dispRate("17. Perfect hash", K, R, ref, t9 - t8);
+    }
+}
+
+/*
+ * testSweep() - Binary vs Eytzinger vs S-tree latency from L1-sized
+ * dictionaries up to SWEEP_MB. Each size gets its own sorted array (random
+ * gaps of 0..3, so about a quarter of the keys repeat and a third of the
+ * queries miss). The indexes are built one at a time to bound memory.
+ */
+void testSweep()
+{
+    mt19937 gen(random_device{}());
+    vector<int> K(BATCH), R(BATCH), E(BATCH);
+
+    // Indexed searches must find the first of the duplicates
+    auto check = [&](const int A[]) {
+        bool ok = true;
+        for (int i = 0; i < BATCH; i++)
+        {
+            int j = E[i];
+            ok &= (j == -1) ? R[i] == -1 : (A[j] == K[i] && (j == 0 || A[j - 1] < K[i]));
+        }
+        return ok;
+    };
+
+    cout << "Binary vs Eytzinger vs S-tree, " << BATCH << " random keys per size (ns per key) ..." << endl;
+    cout << left << setw(12) << "Size" << setw(10) << "Binary" << setw(20) << "Eytzinger" << "S-tree" << endl;
+    for (long n = 1024; n * (long)sizeof(int) <= (SWEEP_MB << 20); n *= 4)
+    {
+        int *A = new int[n], *B, *I;
+        A[0] = 0;
+        for (long i = 1; i < n; i++)
+            A[i] = A[i - 1] + gen() % 4;
+        uniform_int_distribution<> distr(0, A[n - 1]);
+        for (int &k : K)
+            k = distr(gen);
+
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            R[i] = BinarySearch(A, 0, n, K[i]);
+        auto t1 = chrono::high_resolution_clock::now();
+
+        BuildEytzinger(A, n, B, I);
+        auto t2 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            E[i] = EytzingerSearch(B, I, n, K[i]);
+        auto t3 = chrono::high_resolution_clock::now();
+        bool ok = check(A);
+        free(B);
+        free(I);
+
+        STree S;
+        BuildSTree(A, n, S);
+        auto t4 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            E[i] = STreeSearch(S, K[i]);
+        auto t5 = chrono::high_resolution_clock::now();
+        ok &= check(A);
+        free(S.key);
+
+        double b = chrono::duration<double, nano>(t1 - t0).count() / BATCH;
+        double e = chrono::duration<double, nano>(t3 - t2).count() / BATCH;
+        double t = chrono::duration<double, nano>(t5 - t4).count() / BATCH;
+        long kb = n * sizeof(int) >> 10;
+        string size = kb < 1024 ? to_string(kb) + " KB" : to_string(kb >> 10) + " MB";
+        ostringstream es, ts;
+        es << fixed << setprecision(1) << e << " (" << setprecision(2) << b / e << "x)";
+        ts << fixed << setprecision(1) << t << " (" << setprecision(2) << b / t << "x)";
+        cout << left << setw(12) << size << fixed << setprecision(1) << setw(10) << b << setw(20) << es.str()
+             << ts.str() << (ok ? "" : " MISMATCH") << endl;
+        cout.unsetf(ios::fixed);
+
+        delete[] A;
+    }
+}
+
+/*
+ * testLearned() - Lookup latency on keys drawn like the dictionary (so
+ * skewed with -g): the learned index against the searches it replaces.
+ */
+void testLearned()
+{
+    vector<int> K(BATCH), R(BATCH), E(BATCH);
+    for (int &k : K)
+        k = GenKeyNumber();
+
+    // Interpolation can take O(n) per key on skewed data: time a sample
+    auto time = [&](vector<int> &out, int m, auto search) {
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < m; i++)
+            out[i] = search(K[i]);
+        return chrono::duration<double, nano>(chrono::high_resolution_clock::now() - t0).count() / m;
+    };
+    double b = time(R, BATCH, [](int T) { return BinarySearch(arr, MIN, MAX, T); });
+    double p = time(E, BATCH >> 8, [](int T) { return InterpolationSearch(arr, MAX, T); });
+    double l = time(E, BATCH, [](int T) { return LearnedSearch(pgm, arr, T); });
+    bool ok = true;
+    for (int i = 0; i < BATCH; i++)
+        ok &= (E[i] == -1) ? R[i] == -1 : (arr[E[i]] == K[i] && (E[i] == 0 || arr[E[i] - 1] < K[i]));
+
+    cout << "Learned index, " << DIST << " keys (ns per key) ..." << endl;
+    cout << fixed << setprecision(1) << left << setw(20) << "2. Binary" << b << endl
+         << setw(20) << "3. Interpolation" << p << endl
+         << setw(20) << "14. Learned" << l << (ok ? "" : " MISMATCH") << endl;
+    cout.unsetf(ios::fixed);
+}
+
+/*
+ * Every search over arr as one call, for the drivers that run them all.
+ */
+struct Algo
+{
+    const char *name;
+    int (*search)(int T);
+};
+
+vector<Algo> Algorithms()
+{
+    vector<Algo> a = {
+        {"1. Sequence", [](int T) { return SequenceSearch(arr, MAX, T); }},
+        {"2. Binary", [](int T) { return BinarySearch(arr, MIN, MAX, T); }},
+        {"3. Interpolation", [](int T) { return InterpolationSearch(arr, MAX, T); }},
+        {"4. Fibonacci", [](int T) { return FibonacciSearch(arr, MAX - 1, T); }},
+        {"5. Exponential", [](int T) { return ExponentialSearch(arr, MAX - 1, T); }},
+        {"6. Ternary", [](int T) { return TernarySearch(arr, MIN, MAX - 1, T); }},
+        {"7. Jump", [](int T) { return JumpSearch(arr, MAX - 1, T); }},
+        {"11. Sequence SIMD", [](int T) { return SequenceSearchSimd(arr, MAX, T); }},
+        {"12. Jump SIMD", [](int T) { return JumpSearchSimd(arr, MAX - 1, T); }}};
+    if (eyt != NULL)
+        a.push_back({"9. Eytzinger", [](int T) { return EytzingerSearch(eyt, eytIdx, MAX, T); }});
+    if (stree.key != NULL)
+        a.push_back({"10. S-tree", [](int T) { return STreeSearch(stree, T); }});
+    if (!pgm.level.empty())
+        a.push_back({"14. Learned", [](int T) { return LearnedSearch(pgm, arr, T); }});
+    if (hidx.ctrl != NULL)
+    {
+        a.push_back({"16. Hash", [](int T) { return HashSearch(hidx, T); }});
+        a.push_back({"17. Perfect hash", [](int T) { return PerfectHashSearch(mph, arr, T); }});
+    }
+    return a;
+}
+
+/*
+ * testConcurrent() - Read-only query service: k threads, each pinned to a
+ * core, look up random keys in the shared arr for CONCURRENT_MS. Lookups
+ * are counted, not timed, for QPS; one in `stride` is timed for the latency
+ * percentiles. The stride is LAT_SAMPLE for fast searches, so the clock
+ * reads do not dilute the QPS, and shrinks down to every lookup for slow
+ * ones, so each thread still gets about LAT_WANT samples. A percentile p
+ * needs LAT_TAIL samples beyond it (1000 for p99) and is n/a with fewer.
+ * Reported per algorithm and k = 1, 2, 4, ... THREADS: aggregate queries
+ * per second, latency samples and percentiles. As k grows the
+ * searches compete for cache and memory bandwidth, which the scaling
+ * column (QPS / k x single-thread QPS) shows.
+ */
+void testConcurrent()
+{
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    vector<unsigned> counts;
+    for (unsigned k = 1; k < THREADS; k *= 2)
+        counts.push_back(k);
+    counts.push_back(THREADS);
+
+    cout << "Concurrent lookups, " << CONCURRENT_MS << " ms per point, " << cores << " cores ..." << endl;
+    cout << left << setw(20) << "Algorithm" << setw(9) << "Threads" << setw(12) << "MQPS" << setw(10) << "Scaling"
+         << setw(10) << "Samples" << setw(10) << "p50 ns" << setw(10) << "p99 ns" << "p999 ns" << endl;
+    for (const Algo &a : Algorithms())
+    {
+        // Lookups a thread does per window, from a short untimed run
+        mt19937 gen(0);
+        uniform_int_distribution<> distr(MIN, MAX);
+        volatile int sink = 0;
+        long probes = 0;
+        auto c0 = chrono::steady_clock::now();
+        chrono::duration<double> calib = chrono::milliseconds(max(1, CONCURRENT_MS / 20));
+        for (; chrono::steady_clock::now() - c0 < calib; probes++)
+            sink = a.search(distr(gen));
+        (void)sink;
+        double perWindow = probes * (CONCURRENT_MS / 1e3) / calib.count();
+        int stride = (int)max(1.0, min((double)LAT_SAMPLE, perWindow / LAT_WANT));
+
+        double qps1 = 0;
+        for (unsigned k : counts)
+        {
+            vector<vector<uint32_t>> lat(k); // Per-thread sampled latencies, ns
+            vector<size_t> done(k);           // Per-thread lookups
+            atomic<unsigned> ready(0);
+            atomic<bool> stop(false);
+            vector<thread> pool;
+            for (unsigned t = 0; t < k; t++)
+                pool.emplace_back([&, t]() {
+                    cpu_set_t cpu;
+                    CPU_ZERO(&cpu);
+                    CPU_SET(t % cores, &cpu);
+                    pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu);
+
+                    mt19937 gen(t + 1);
+                    uniform_int_distribution<> distr(MIN, MAX);
+                    vector<int> K(QUERY_KEYS);
+                    for (int &x : K)
+                        x = distr(gen);
+                    vector<uint32_t> &L = lat[t];
+                    L.reserve(2 * LAT_WANT);
+                    volatile int sink = 0;
+
+                    ready++;
+                    while (ready < k) // Start together
+                        this_thread::yield();
+                    size_t i = 0;
+                    for (int skip = 0; !stop.load(memory_order_relaxed); i++)
+                    {
+                        if (skip-- > 0)
+                        {
+                            sink = a.search(K[i % QUERY_KEYS]);
+                            continue;
+                        }
+                        skip = stride - 1;
+                        auto t0 = chrono::steady_clock::now();
+                        sink = a.search(K[i % QUERY_KEYS]);
+                        auto t1 = chrono::steady_clock::now();
+                        L.push_back(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+                    }
+                    done[t] = i;
+                    (void)sink;
+                });
+            while (ready < k)
+                this_thread::yield();
+            auto t0 = chrono::steady_clock::now();
+            this_thread::sleep_for(chrono::milliseconds(CONCURRENT_MS));
+            stop = true;
+            for (thread &th : pool)
+                th.join();
+            double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+            vector<uint32_t> all;
+            for (vector<uint32_t> &L : lat)
+                all.insert(all.end(), L.begin(), L.end());
+            auto pct = [&](double p) {
+                if (all.size() < (size_t)(LAT_TAIL / (1 - p) + 0.5))
+                    return string("n/a");
+                auto it = all.begin() + min(all.size() - 1, (size_t)(p * all.size()));
+                nth_element(all.begin(), it, all.end());
+                return to_string(*it);
+            };
+            double qps = accumulate(done.begin(), done.end(), (size_t)0) / sec;
+            if (k == 1)
+                qps1 = qps;
+            cout << left << setw(20) << a.name << setw(9) << k << fixed << setprecision(3) << setw(12) << qps / 1e6
+                 << setprecision(2) << setw(10) << qps / (k * qps1) << setw(10) << all.size() << setw(10) << pct(0.5)
+                 << setw(10) << pct(0.99)
+                 << pct(0.999) << endl;
+            cout.unsetf(ios::fixed);
+        }
+    }
+}
+
+/*
+ * testColdWarm() - Per search: COLD_KEYS random lookups right after the
+ * mapped dictionary is evicted (page faults, disk reads), then the same keys
+ * again on the now resident pages.
+ */
+void testColdWarm(int fd)
+{
+    mt19937 gen(random_device{}());
+    uniform_int_distribution<> distr(MIN, MAX);
+    vector<int> K(COLD_KEYS);
+    for (int &k : K)
+        k = distr(gen);
+
+    cout << "Cold vs warm pages, " << COLD_KEYS << " keys (ns per key) ..." << endl;
+    cout << left << setw(20) << "Algorithm" << setw(14) << "Cold" << "Warm" << endl;
+    for (const Algo &a : Algorithms())
+    {
+        volatile int sink = 0;
+        double t[2];
+        evictDictionary(fd);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            auto t0 = chrono::high_resolution_clock::now();
+            for (int k : K)
+                sink = a.search(k);
+            t[pass] = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - t0).count() / COLD_KEYS;
+        }
+        (void)sink;
+        cout << left << setw(20) << a.name << fixed << setprecision(1) << setw(14) << t[0] << t[1] << endl;
+        cout.unsetf(ios::fixed);
+    }
+}
+
+/*
+ * Every lower_bound over arr, for the range benchmark.
+ */
+struct Ordered
+{
+    const char *name;
+    long (*lowerBound)(int T);
+};
+
+vector<Ordered> OrderedIndexes()
+{
+    vector<Ordered> o = {{"2. Binary", [](int T) { return LowerBound(arr, MAX, T); }}};
+    if (eyt != NULL)
+        o.push_back({"9. Eytzinger", [](int T) { return EytzingerLowerBound(eyt, eytIdx, MAX, T); }});
+    if (stree.key != NULL)
+        o.push_back({"10. S-tree", [](int T) { return STreeLowerBound(stree, T); }});
+    if (!pgm.level.empty())
+        o.push_back({"14. Learned", [](int T) { return LearnedLowerBound(pgm, arr, T); }});
+    return o;
+}
+
+/*
+ * testRange() - Positional queries over every ordered index: lower_bound,
+ * equal_range, RangeCount over [T, T + RANGE_WIDTH], and a range scan that
+ * also sums the keys it counts. Results are checked against the standard
+ * library. Run with -g dups for the heavy-duplicate case.
+ */
+void testRange()
+{
+    mt19937 gen(random_device{}());
+    uniform_int_distribution<> distr(MIN, MAX);
+    vector<int> K(BATCH);
+    for (int &k : K)
+        k = distr(gen);
+    auto hiOf = [](int T) { return (int)min<long>(INT_MAX, (long)T + RANGE_WIDTH); };
+    volatile long long sink; // Keeps the range scan
+
+    cout << "Range queries, width " << RANGE_WIDTH << ", " << DIST << " keys (ns per query) ..." << endl;
+    cout << left << setw(20) << "Index" << setw(13) << "lower_bound" << setw(13) << "equal_range" << setw(13) << "RangeCount"
+         << "Range scan" << endl;
+    for (const Ordered &o : OrderedIndexes())
+    {
+        auto lb = o.lowerBound;
+        vector<long> L(BATCH), C(BATCH);
+        vector<pair<long, long>> E(BATCH);
+        long long sum = 0;
+        chrono::high_resolution_clock::time_point t[5];
+        t[0] = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            L[i] = lb(K[i]);
+        t[1] = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            E[i] = EqualRangeBy(lb, MAX, K[i]);
+        t[2] = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            C[i] = RangeCountBy(lb, MAX, K[i], hiOf(K[i]));
+        t[3] = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+        {
+            long a = lb(K[i]), b = UpperBoundBy(lb, MAX, hiOf(K[i]));
+            for (long j = a; j < b; j++)
+                sum += arr[j];
+        }
+        t[4] = chrono::high_resolution_clock::now();
+        sink = sum;
+
+        bool ok = true;
+        for (int i = 0; i < BATCH && ok; i++)
+        {
+            auto r = equal_range(arr, arr + MAX, K[i]);
+            ok = L[i] == r.first - arr && E[i].first == r.first - arr && E[i].second == r.second - arr &&
+                 C[i] == upper_bound(arr, arr + MAX, hiOf(K[i])) - r.first;
+        }
+        cout << left << setw(20) << o.name << fixed << setprecision(1);
+        for (int j = 0; j < 4; j++)
+            cout << setw(j < 3 ? 13 : 0) << chrono::duration<double, nano>(t[j + 1] - t[j]).count() / BATCH;
+        cout << (ok ? "" : " MISMATCH") << endl;
+        cout.unsetf(ios::fixed);
+    }
+    (void)sink;
+}
+
+/*
+ * A fixed-width string key: N bytes, ordered by memcmp. Not arithmetic, so
+ * it goes through the comparator paths of the search library.
+ */
+template <size_t N>
+struct FixedKey
+{
+    char s[N];
+    bool operator<(const FixedKey &o) const { return memcmp(s, o.s, N) < 0; }
+    bool operator==(const FixedKey &o) const { return memcmp(s, o.s, N) == 0; }
+};
+
+/*
+ * benchType() - One row of testTypes(): MAX keys made by gen(), sorted,
+ * then BATCH lookups (half of them hits) through each templated search.
+ */
+template <class Key, class Gen>
+void benchType(const char *name, Gen gen)
+{
+    mt19937 pick(random_device{}());
+    uniform_int_distribution<> distr(0, MAX - 1);
+    vector<Key> A(MAX), Q(BATCH);
+    for (Key &a : A)
+        a = gen();
+    sort(A.begin(), A.end());
+    for (int i = 0; i < BATCH; i++)
+        Q[i] = (i & 1) ? A[distr(pick)] : gen();
+    Key *B;
+    int *I;
+    BuildEytzinger(A.data(), MAX, B, I);
+
+    vector<int> R(BATCH), E(BATCH);
+    bool ok = true;
+    auto check = [&]() {
+        for (int i = 0; i < BATCH; i++)
+            ok &= (E[i] == -1) ? R[i] == -1 : (R[i] != -1 && A[E[i]] == Q[i]);
+    };
+    auto time = [&](vector<int> &out, auto search) {
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            out[i] = search(Q[i]);
+        return chrono::duration<double, nano>(chrono::high_resolution_clock::now() - t0).count() / BATCH;
+    };
+    const Key *a = A.data();
+    double b = time(R, [&](const Key &T) { return BinarySearch(a, 0, MAX, T); });
+    double l = time(E, [&](const Key &T) {
+        long i = LowerBound(a, MAX, T);
+        return (i < MAX && a[i] == T) ? (int)i : -1;
+    });
+    check();
+    double p = time(E, [&](const Key &T) { return InterpolationSearch(a, MAX, T); });
+    check();
+    double e = time(E, [&](const Key &T) { return EytzingerSearch(B, I, MAX, T); });
+    check();
+    BinarySearchBatch(a, MAX, Q.data(), BATCH, E.data());
+    check();
+    free(B);
+    free(I);
+
+    // equal_range, counted as its width, against the standard library's
+    double r = time(E, [&](const Key &T) {
+        pair<long, long> er = EqualRange(a, MAX, T);
+        return (int)(er.second - er.first);
+    });
+    for (int i = 0; i < BATCH; i++)
+    {
+        auto std_er = equal_range(A.begin(), A.end(), Q[i]);
+        ok &= E[i] == std_er.second - std_er.first;
+    }
+
+    cout << left << setw(16) << name << fixed << setprecision(1) << setw(10) << b << setw(14) << l << setw(15)
+         << p << setw(12) << e << r << (ok ? "" : " MISMATCH") << endl;
+    cout.unsetf(ios::fixed);
+}
+
+/*
+ * testTypes() - The templated searches on other key types, int first as
+ * the baseline. Interpolation on strings falls back to Binary.
+ */
+void testTypes()
+{
+    mt19937_64 gen(random_device{}());
+    cout << "Search library by key type, " << MAX << " keys (ns per key) ..." << endl;
+    cout << left << setw(16) << "Key" << setw(10) << "Binary" << setw(14) << "LowerBound" << setw(15)
+         << "Interpolation" << setw(12) << "Eytzinger" << "EqualRange" << endl;
+    benchType<int>("int", [&]() { return (int)(gen() % (MAX + 1)); });
+    benchType<uint64_t>("uint64_t", [&]() { return (uint64_t)gen(); });
+    benchType<float>("float", [&]() { return uniform_real_distribution<float>(0, 1)(gen); });
+    benchType<FixedKey<16>>("char[16]", [&]() {
+        FixedKey<16> k;
+        for (char &c : k.s)
+            c = 'a' + gen() % 26;
+        return k;
+    });
+}
+
+/*
+ * testIndexes() - Ordered vs hash indexes side by side: build time, bytes
+ * beyond arr, and latency of BATCH point lookups (all agreeing with
+ * BinarySearch on found / not found). Each index is built afresh here.
+ */
+void testIndexes()
+{
+    mt19937 gen(random_device{}());
+    uniform_int_distribution<> distr(MIN, MAX);
+    vector<int> K(BATCH), R(BATCH), E(BATCH);
+    for (int &k : K)
+        k = distr(gen);
+    for (int i = 0; i < BATCH; i++)
+        R[i] = BinarySearch(arr, MIN, MAX, K[i]);
+
+    cout << "Index trade-offs, " << MAX << " keys ..." << endl;
+    cout << left << setw(20) << "Index" << setw(12) << "Build ms" << setw(14) << "Bytes" << "ns per lookup" << endl;
+    auto row = [&](const char *name, double buildMs, long bytes, auto search) {
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            E[i] = search(K[i]);
+        double ns = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - t0).count() / BATCH;
+        bool ok = true;
+        for (int i = 0; i < BATCH; i++)
+            ok &= (E[i] == -1) ? R[i] == -1 : (R[i] != -1 && arr[E[i]] == K[i]);
+        cout << left << setw(20) << name << fixed << setprecision(1) << setw(12) << buildMs << setw(14) << bytes << ns
+             << (ok ? "" : " MISMATCH") << endl;
+        cout.unsetf(ios::fixed);
+    };
+    auto since = [](chrono::high_resolution_clock::time_point t) {
+        return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - t).count();
+    };
+
+    row("2. Binary", 0, 0, [](int T) { return BinarySearch(arr, MIN, MAX, T); });
+
+    int *B, *I;
+    auto t = chrono::high_resolution_clock::now();
+    BuildEytzinger(arr, MAX, B, I);
+    row("9. Eytzinger", since(t), 2L * (MAX + 1) * sizeof(int), [&](int T) { return EytzingerSearch(B, I, MAX, T); });
+    free(B);
+    free(I);
+
+    STree S;
+    t = chrono::high_resolution_clock::now();
+    BuildSTree(arr, MAX, S);
+    row("10. S-tree", since(t), S.size * sizeof(int), [&](int T) { return STreeSearch(S, T); });
+    free(S.key);
+
+    PGMIndex P;
+    t = chrono::high_resolution_clock::now();
+    BuildPGM(arr, MAX, PGM_EPS > 0 ? PGM_EPS : 64, P);
+    row("14. Learned", since(t), PGMBytes(P), [&](int T) { return LearnedSearch(P, arr, T); });
+
+    HashIndex H;
+    t = chrono::high_resolution_clock::now();
+    BuildHashIndex(arr, MAX, H);
+    row("16. Hash", since(t), HashBytes(H), [&](int T) { return HashSearch(H, T); });
+    free(H.ctrl);
+    free(H.slot);
+
+    PerfectHash M;
+    t = chrono::high_resolution_clock::now();
+    BuildPerfectHash(arr, MAX, M);
+    row("17. Perfect hash", since(t), PerfectHashBytes(M), [&](int T) { return PerfectHashSearch(M, arr, T); });
+}
+
+/*
+ * testCrossover() - Lower bound in a small, cache-resident sorted range:
+ * branchy BinarySearch vs a branchless full SIMD scan (countLess). The scan
+ * does n/width compares but never mispredicts; the crossover is the first
+ * size where binary search wins.
+ */
+void testCrossover()
+{
+    mt19937 gen(random_device{}());
+    vector<int> K(BATCH);
+    long crossover = 0;
+    volatile int sink = 0;
+
+    cout << "SIMD scan (" << SCAN.isa << ") vs Binary on small sorted ranges (ns per key) ..." << endl;
+    cout << left << setw(12) << "Keys" << setw(10) << "Binary" << "Scan" << endl;
+    for (int n = 8; n <= 8192; n *= 2)
+    {
+        vector<int> A(n);
+        for (int i = 1; i < n; i++)
+            A[i] = A[i - 1] + gen() % 4;
+        uniform_int_distribution<> distr(0, A[n - 1]);
+        for (int &k : K)
+            k = distr(gen);
+
+        int acc = 0;
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            acc += BinarySearch(A.data(), 0, n, K[i]);
+        auto t1 = chrono::high_resolution_clock::now();
+        for (int i = 0; i < BATCH; i++)
+            acc += SCAN.countLess(A.data(), n, K[i]);
+        auto t2 = chrono::high_resolution_clock::now();
+        sink = acc;
+
+        double b = chrono::duration<double, nano>(t1 - t0).count() / BATCH;
+        double v = chrono::duration<double, nano>(t2 - t1).count() / BATCH;
+        if (crossover == 0 && b < v)
+            crossover = n;
+        cout << left << setw(12) << n << fixed << setprecision(1) << setw(10) << b << v << endl;
+        cout.unsetf(ios::fixed);
+    }
+    (void)sink;
+    if (crossover)
+        cout << "Binary search wins from " << crossover << " keys." << endl;
+    else
+        cout << "SIMD scan wins at every size." << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option LONG_OPTS[] = {
+        {"eytzinger", no_argument, NULL, 'e'},
+        {"btree", no_argument, NULL, 'b'},
+        {"sweep", required_argument, NULL, 'z'},
+        {"simd", required_argument, NULL, 's'},
+        {"crossover", no_argument, NULL, 'x'},
+        {"pgm", optional_argument, NULL, 'p'},
+        {"dist", required_argument, NULL, 'g'},
+        {"concurrent", optional_argument, NULL, 'c'},
+        {"threads", required_argument, NULL, 't'},
+        {"size", required_argument, NULL, 'n'},
+        {"save", required_argument, NULL, 'w'},
+        {"open", required_argument, NULL, 'o'},
+        {"populate", no_argument, NULL, 'P'},
+        {"hugepages", no_argument, NULL, 'H'},
+        {"cold", no_argument, NULL, 'C'},
+        {"range", optional_argument, NULL, 'r'},
+        {"types", no_argument, NULL, 'T'},
+        {"hash", no_argument, NULL, 'a'},
+        {NULL, 0, NULL, 0}};
+    int opt, fd = -1;
+
+    // Check cmd line args
+    while ((opt = getopt_long(argc, argv, "ebz:s:xp::g:c::t:n:w:o:PHCr::Ta", LONG_OPTS, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'e':
+            EYTZINGER = true;
+            break;
+        case 'b':
+            BTREE = true;
+            break;
+        case 'z':
+            SWEEP_MB = stol(optarg);
+            break;
+        case 's':
+            SIMD_CAP = optarg;
+            break;
+        case 'x':
+            CROSSOVER = true;
+            break;
+        case 'p':
+            PGM_EPS = optarg ? stoi(optarg) : 64;
+            break;
+        case 'g':
+            DIST = optarg;
+            break;
+        case 'c':
+            CONCURRENT_MS = optarg ? stoi(optarg) : 200;
+            break;
+        case 't':
+            THREADS = stoi(optarg);
+            break;
+        case 'n':
+            MAX = stoi(optarg);
+            break;
+        case 'w':
+            SAVE_FILE = optarg;
+            break;
+        case 'o':
+            OPEN_FILE = optarg;
+            break;
+        case 'P':
+            POPULATE = true;
+            break;
+        case 'H':
+            HUGEPAGES = true;
+            break;
+        case 'C':
+            COLD = true;
+            break;
+        case 'r':
+            RANGE_WIDTH = optarg ? stoi(optarg) : 1000;
+            break;
+        case 'T':
+            TYPES = true;
+            break;
+        case 'a':
+            HASH = true;
+            break;
+        default:
+            cerr << MSG_USAGE;
+            return 1;
+        }
+    }
+    if (optind != argc || PGM_EPS < 0 || CONCURRENT_MS < 0 || THREADS < 1 || MAX < 1 ||
+        (COLD && OPEN_FILE.empty()) ||
+        (DIST != "uniform" && DIST != "lognormal" && DIST != "power" && DIST != "dups"))
+    {
+        cerr << MSG_USAGE;
+        return 1;
+    }
+
     try
     {
+        SelectScanKernels(SIMD_CAP);
         // Instantiation
-        BuildDataDictionary();
+        if (!OPEN_FILE.empty())
+            fd = OpenDictionary(OPEN_FILE);
+        else
+            BuildDataDictionary();
+        BuildIndexes();
+        if (!SAVE_FILE.empty())
+            SaveDictionary(SAVE_FILE);
+        if (COLD)
+            testColdWarm(fd);
         // Generate key
         key = GenKeyNumber();
         // Start test
         test();
+        testBatch();
+        if (SWEEP_MB > 0)
+            testSweep();
+        if (CROSSOVER)
+            testCrossover();
+        if (PGM_EPS > 0)
+            testLearned();
+        if (CONCURRENT_MS > 0)
+            testConcurrent();
+        if (RANGE_WIDTH >= 0)
+            testRange();
+        if (TYPES)
+            testTypes();
+        if (HASH)
+            testIndexes();
     }
     catch (const std::exception &e)
     {
         std::cerr << e.what() << '\n';
     }
 
-    delete[] arr;
+    // With a mapped file, free only the indexes built after opening it
+    auto owned = [](const void *p) {
+        return MAPPED == NULL || (const char *)p < MAPPED || (const char *)p >= MAPPED + MAPPED_BYTES;
+    };
+    if (owned(eyt))
+    {
+        free(eyt);
+        free(eytIdx);
+    }
+    if (owned(stree.key))
+        free(stree.key);
+    if (MAPPED != NULL)
+    {
+        munmap(MAPPED, MAPPED_BYTES);
+        close(fd);
+    }
+    else
+        delete[] arr;
+    free(hidx.ctrl);
+    free(hidx.slot);
     return 0;
 }
\ No newline at end of file
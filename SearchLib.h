@@ -0,0 +1,670 @@
+/*
+    File: SearchLib.h - Search algorithms over sorted arrays, header only.
+    Copyright:  (c) freeants. All rights reserved.
+
+    Templates over the key type and its ordering, shared by SearchComp.cc
+    and anything else that searches sorted keys (64-bit IDs, floats,
+    fixed-width strings). No globals; GROUP is the only tuning knob.
+ */
+#ifndef SEARCHLIB_H
+#define SEARCHLIB_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+const int GROUP = 16; // Searches interleaved by the batched variants
+
+/* Search library
+ * Every search is a template over the key type Key and a strict weak
+ * ordering Less (std::less by default), so the same code serves int keys,
+ * 64-bit IDs, floats or fixed-width strings. With std::less on an
+ * arithmetic type, keyEq() is a plain == and the compares compile to
+ * branchless selects where the code allows; any other ordering is used
+ * through Less only. InterpolationSearch needs arithmetic keys (others
+ * fall back to BinarySearch), and the SIMD, S-tree and learned paths are
+ * int specializations.
+ */
+template <class Key, class Less>
+inline bool keyEq(const Key &a, const Key &b, Less lt)
+{
+    return !lt(a, b) && !lt(b, a);
+}
+
+template <class Key>
+inline bool keyEq(const Key &a, const Key &b, std::less<Key>)
+{
+    return a == b;
+}
+
+/* 1. SequenceSearch
+ * A linear search sequentially checks each element of the list until it 
+ * finds an element that matches the target value. If the algorithm reaches
+ * the end of the list, the search terminates unsuccessfully.
+ * Average Search Length (ASL) = (n+1) / 2, Average performance O(n/2), Space:O(1)
+ */
+template <class Key, class Less = std::less<Key>>
+int SequenceSearch(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    for (int i = 0; i < n; i++)
+        if (keyEq(A[i], T, lt))
+            return i;
+    return -1;
+}
+
+/* 2. BinarySearch
+ * Binary search works on sorted arrays. Binary search begins by comparing
+ * an element in the middle of the array with the target value. If the target
+ * value matches the element, its position in the array is returned. 
+ * If the target value is less than the element, the search continues in the
+ * lower half of the array. If the target value is greater than the element, 
+ * the search continues in the upper half of the array. By doing this,
+ * the algorithm eliminates the half in which the target value cannot lie 
+ * in each iteration.
+ * ASL = log(n+1), Average Performance: O(log n), Space complexity: O(1)
+ */
+template <class Key, class Less = std::less<Key>>
+int BinarySearch(const Key A[], int low, int high, const Key &T, Less lt = Less())
+{
+    int L = low, R = high - 1, m;
+    while (L <= R)
+    {
+        m = (L + R) / 2;
+        if (lt(A[m], T))
+            L = m + 1;
+        else if (lt(T, A[m]))
+            R = m - 1;
+        else
+            return m;
+    }
+    return -1;
+}
+
+/* 3. Interpolation Search
+ * The Interpolation Search is an improvement over Binary Search for instances,
+ * where the values in a sorted array are uniformly distributed. 
+ * Binary Search always goes to the middle element to check. On the other hand, 
+ * interpolation search may go to different locations according to the value 
+ * of the key being searched. For example, if the value of the key is closer
+ * to the last element, interpolation search is likely to start search 
+ * toward the end side.
+ * O(log log n)
+ */
+template <class Key>
+typename std::enable_if<std::is_arithmetic<Key>::value, int>::type
+InterpolationSearch(const Key A[], int n, const Key &T)
+{
+    // Find indexes of two corners
+    int lo = 0, hi = (n - 1);
+
+    // Since array is sorted, an element present
+    // in array must be in range defined by corner
+    while (lo <= hi && T >= A[lo] && T <= A[hi])
+    {
+        if (lo == hi)
+        {
+            if (A[lo] == T)
+                return lo;
+            return -1;
+        }
+        // A run of duplicates holding T: the probe would be 0/0
+        if (A[hi] == A[lo])
+            return lo;
+        // Probing the position with keeping
+        // uniform distribution in mind.
+        int pos = lo + (((double)(hi - lo) /
+                         (A[hi] - A[lo])) *
+                        (T - A[lo]));
+
+        // Condition of target found
+        if (A[pos] == T)
+            return pos;
+
+        // If x is larger, x is in upper part
+        if (A[pos] < T)
+            lo = pos + 1;
+
+        // If x is smaller, x is in the lower part
+        else
+            hi = pos - 1;
+    }
+    return -1;
+}
+
+/* Without arithmetic on the keys there is nothing to interpolate */
+template <class Key>
+typename std::enable_if<!std::is_arithmetic<Key>::value, int>::type
+InterpolationSearch(const Key A[], int n, const Key &T)
+{
+    return BinarySearch(A, 0, n, T);
+}
+
+/* 4. FibonacciSearch
+ * Fibonacci Search is a comparison-based technique that uses Fibonacci 
+ * numbers to search an element in a sorted array.
+ * O(log n)
+ */
+template <class Key, class Less = std::less<Key>>
+int FibonacciSearch(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    /* Initialize fibnacci numbers */
+    int fibMMm2 = 0;              // (m-2)'th Fibonacci No.
+    int fibMMm1 = 1;              // (m-1)'th Fibonacci No.
+    int fibM = fibMMm2 + fibMMm1; // m'th Fibonacci
+
+    /* fibM is going to store the smallest Fibonacci
+       Number greater than or equal to n */
+    while (fibM < n)
+    {
+        fibMMm2 = fibMMm1;
+        fibMMm1 = fibM;
+        fibM = fibMMm2 + fibMMm1;
+    }
+
+    // Marks the eliminated range from front
+    int offset = -1;
+
+    /* while there are elements to be inspected. Note that
+       we compare arr[fibMm2] with x. When fibM becomes 1,
+       fibMm2 becomes 0 */
+    while (fibM > 1)
+    {
+        // Check if fibMm2 is a valid location
+        int i = std::min(offset + fibMMm2, n - 1);
+
+        /* If T is greater than the value at index fibMm2,
+           cut the subarray array from offset to i */
+        if (lt(A[i], T))
+        {
+            fibM = fibMMm1;
+            fibMMm1 = fibMMm2;
+            fibMMm2 = fibM - fibMMm1;
+            offset = i;
+        }
+
+        /* If T is greater than the value at index fibMm2,
+           cut the subarray after i+1  */
+        else if (lt(T, A[i]))
+        {
+            fibM = fibMMm2;
+            fibMMm1 = fibMMm1 - fibMMm2;
+            fibMMm2 = fibM - fibMMm1;
+        }
+
+        /* element found. return index */
+        else
+            return i;
+    }
+
+    /* comparing the last element with x */
+    if (fibMMm1 && keyEq(A[offset + 1], T, lt))
+        return offset + 1;
+
+    /*element not found. return -1 */
+    return -1;
+}
+
+/*5. ExponentialSearch
+ * Exponential search allows for searching through a sorted, unbounded list 
+ * for a specified input value (the search "key"). The algorithm consists of 
+ * two stages. The first stage determines a range in which the search key 
+ * would reside if it were in the list. In the second stage, a binary search 
+ * is performed on this range. In the first stage, assuming that the list 
+ * is sorted in ascending order, the algorithm looks for the first exponent, 
+ * j, where the value 2j is greater than the search key. This value, 2j 
+ * becomes the upper bound for the binary search with the previous power of 
+ * 2, 2j - 1, being the lower bound for the binary search.
+ * Average performance: O(log n), Space complexity: O(1).
+ */
+template <class Key, class Less = std::less<Key>>
+int ExponentialSearch(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    if (n == 0)
+        return -1;
+    int bound = 1;
+    while (bound < n && lt(A[bound], T))
+    {
+        bound *= 2;
+    }
+    return BinarySearch(A, bound / 2, std::min(bound + 1, n), T, lt);
+}
+
+/* 6. TernarySearch
+ * Ternary search is a divide and conquer algorithm that can be used to find 
+ * an element in an array. It is similar to binary search where we divide 
+ * the array into two parts but in this algorithm, we divide the given array 
+ * into three parts and determine which has the key (searched element). 
+ * We can divide the array into three parts by taking m1 and m2 which 
+ * can be calculated as shown below. Initially, l and r will be equal to 0 
+ * and n-1 respectively, where n is the length of the array. 
+ * O(log3 n)
+ */
+template <class Key, class Less = std::less<Key>>
+int TernarySearch(const Key A[], int l, int r, const Key &T, Less lt = Less())
+{
+    int m1 = 0, m2 = 0;
+    if (l <= r)
+    {
+        m1 = l + (r - l) / 3;
+        m2 = r - (r - l) / 3;
+        if (keyEq(A[m1], T, lt))
+            return m1;
+        if (keyEq(A[m2], T, lt))
+            return m2;
+        if (lt(T, A[m1]))
+            return TernarySearch(A, l, m1 - 1, T, lt);
+        else if (lt(A[m2], T))
+            return TernarySearch(A, m2 + 1, r, T, lt);
+        else
+            return TernarySearch(A, m1 + 1, m2 - 1, T, lt);
+    }
+    return -1;
+}
+
+/*7. JumpSearch
+ * Jump Search is a searching algorithm for sorted arrays. The basic idea is
+ * to check fewer elements (than linear search) by jumping ahead by fixed 
+ * steps or skipping some elements in place of searching all elements.
+ * O(√n), O(1)
+ */
+template <class Key, class Less = std::less<Key>>
+int JumpSearch(const Key A[], int n, const Key &T, Less lt = Less())
+{
+    if (n == 0)
+        return -1;
+    int step = std::sqrt(n);
+    int prev = 0;
+    while (lt(A[std::min(step, n) - 1], T))
+    {
+        prev = step;
+        step += std::sqrt(n);
+        if (prev >= n)
+            return -1;
+    }
+
+    while (lt(A[prev], T))
+    {
+        prev++;
+        if (prev == std::min(step, n))
+            return -1;
+    }
+
+    if (keyEq(A[prev], T, lt))
+        return prev;
+
+    return -1;
+}
+
+/* 8. Batched searches
+ * A single search stalls on every probe that misses the cache, since the
+ * next probe depends on the value just loaded. Looking up many keys at once
+ * lets those misses overlap: each step of one search prefetches its next
+ * probe, and the other searches in the group run while the line arrives.
+ * Every batched variant stores into R[i] what the single-key search would
+ * return for K[i] (for duplicate keys, possibly another matching index).
+ * Fibonacci has no batched variant: its next step size depends on which
+ * way the last probe went, so the keys of a group fall out of step after
+ * one probe, and what is left is a binary search BinarySearchBatch covers.
+ */
+
+/* BinarySearchBatch - group prefetching.
+ * GROUP branchless lower-bound searches advance in lockstep. They all halve
+ * the same length, so every step touches one new line per key, and the
+ * prefetch for a key is issued GROUP-1 searches ahead of its use.
+ * Returns the first matching index, or -1.
+ */
+template <class Key, class Less = std::less<Key>>
+void BinarySearchBatch(const Key A[], int n, const Key K[], int m, int R[], Less lt = Less())
+{
+    const Key *base[GROUP];
+    for (int g = 0; g < m; g += GROUP)
+    {
+        int c = std::min(GROUP, m - g);
+        for (int j = 0; j < c; j++)
+            base[j] = A;
+        int len = n;
+        while (len > 1)
+        {
+            int half = len / 2;
+            len -= half;
+            for (int j = 0; j < c; j++)
+            {
+                base[j] += lt(base[j][half - 1], K[g + j]) ? half : 0;
+                __builtin_prefetch(base[j] + len / 2 - 1);
+            }
+        }
+        for (int j = 0; j < c; j++)
+        {
+            int i = (int)(base[j] - A) + (n > 0 && lt(*base[j], K[g + j]));
+            R[g + j] = (i < n && keyEq(A[i], K[g + j], lt)) ? i : -1;
+        }
+    }
+}
+
+/* ExponentialSearchBatch - group prefetching.
+ * The doubling phase runs in lockstep: a key whose bound has passed it
+ * leaves the round, the others prefetch their next bound. The binary phase
+ * then halves every key's own range together, as BinarySearchBatch does,
+ * until each range is one key long. Returns the first matching index, or -1.
+ */
+template <class Key, class Less = std::less<Key>>
+void ExponentialSearchBatch(const Key A[], int n, const Key K[], int m, int R[], Less lt = Less())
+{
+    int bound[GROUP], len[GROUP], act[GROUP];
+    const Key *base[GROUP];
+    for (int g = 0; g < m; g += GROUP)
+    {
+        int c = std::min(GROUP, m - g), a = 0;
+        for (int j = 0; j < c; j++)
+        {
+            bound[j] = 1;
+            if (n > 0)
+                act[a++] = j;
+            else
+                R[g + j] = -1;
+        }
+        if (a == 0)
+            continue;
+        while (a > 0)
+        {
+            for (int i = 0; i < a;)
+            {
+                int j = act[i];
+                if (bound[j] < n && lt(A[bound[j]], K[g + j]))
+                {
+                    bound[j] *= 2;
+                    __builtin_prefetch(A + std::min(bound[j], n - 1));
+                    i++;
+                }
+                else
+                    act[i] = act[--a];
+            }
+        }
+
+        int left = 0;
+        for (int j = 0; j < c; j++)
+        {
+            base[j] = A + bound[j] / 2;
+            len[j] = std::min(bound[j] + 1, n) - bound[j] / 2;
+            left += len[j] > 1;
+        }
+        while (left > 0)
+        {
+            left = 0;
+            for (int j = 0; j < c; j++)
+            {
+                if (len[j] <= 1)
+                    continue;
+                int half = len[j] / 2;
+                len[j] -= half;
+                base[j] += lt(base[j][half - 1], K[g + j]) ? half : 0;
+                __builtin_prefetch(base[j] + len[j] / 2 - 1);
+                left += len[j] > 1;
+            }
+        }
+        for (int j = 0; j < c; j++)
+        {
+            int i = (int)(base[j] - A) + lt(*base[j], K[g + j]);
+            R[g + j] = (i < n && keyEq(A[i], K[g + j], lt)) ? i : -1;
+        }
+    }
+}
+
+/* JumpSearchBatch - group prefetching.
+ * The keys of a group walk the block ends in lockstep, each prefetching
+ * its next block end; a key leaves the round once its block is found and
+ * prefetches the start of it. The in-block scans run after the whole group
+ * has found its blocks. Returns the first matching index, or -1.
+ */
+template <class Key, class Less = std::less<Key>>
+void JumpSearchBatch(const Key A[], int n, const Key K[], int m, int R[], Less lt = Less())
+{
+    int step = std::sqrt(n);
+    int prev[GROUP], act[GROUP];
+    for (int g = 0; g < m; g += GROUP)
+    {
+        int c = std::min(GROUP, m - g), a = 0;
+        for (int j = 0; j < c; j++)
+        {
+            prev[j] = 0;
+            if (n > 0)
+                act[a++] = j;
+        }
+        while (a > 0)
+        {
+            for (int i = 0; i < a;)
+            {
+                int j = act[i];
+                if (lt(A[std::min(prev[j] + step, n) - 1], K[g + j]))
+                {
+                    prev[j] += step;
+                    if (prev[j] >= n) // Past the last key: no match
+                    {
+                        act[i] = act[--a];
+                        continue;
+                    }
+                    __builtin_prefetch(A + std::min(prev[j] + step, n) - 1);
+                    i++;
+                }
+                else
+                {
+                    __builtin_prefetch(A + prev[j]);
+                    act[i] = act[--a];
+                }
+            }
+        }
+        for (int j = 0; j < c; j++)
+        {
+            int i = prev[j], end = std::min(prev[j] + step, n);
+            while (i < end && lt(A[i], K[g + j]))
+                i++;
+            R[g + j] = (i < end && keyEq(A[i], K[g + j], lt)) ? i : -1;
+        }
+    }
+}
+
+/* InterpolationSearchBatch - asynchronous memory access chaining (AMAC).
+ * Interpolation probes are data dependent and take a different number of
+ * steps per key, so lockstep groups would idle. Instead GROUP independent
+ * state machines are visited round robin: each visit consumes the values
+ * prefetched on the previous visit, issues the next prefetch, and a slot
+ * whose search ends is refilled with the next key at once.
+ */
+template <class Key>
+typename std::enable_if<std::is_arithmetic<Key>::value>::type
+InterpolationSearchBatch(const Key A[], int n, const Key K[], int m, int R[])
+{
+    struct Slot
+    {
+        int k;      // Index of the key, -1 if idle
+        int lo, hi; // Search range, as in InterpolationSearch
+        int pos;    // Pending probe, -1 while A[lo] and A[hi] are pending
+    } s[GROUP];
+
+    int next = 0, busy = 0;
+    for (int j = 0; j < GROUP; j++)
+        s[j].k = -1;
+    do
+    {
+        for (int j = 0; j < GROUP; j++)
+        {
+            Slot &e = s[j];
+            if (e.k < 0)
+            {
+                if (next == m)
+                    continue;
+                e.k = next++, e.lo = 0, e.hi = n - 1, e.pos = -1;
+                __builtin_prefetch(A + e.lo);
+                __builtin_prefetch(A + e.hi);
+                busy++;
+                continue;
+            }
+
+            Key T = K[e.k];
+            int res = -2; // -2 while still searching
+            if (e.pos < 0)
+            {
+                // Stage 1: bounds are in cache, pick the probe
+                if (!(e.lo <= e.hi && T >= A[e.lo] && T <= A[e.hi]))
+                    res = -1;
+                else if (e.lo == e.hi || A[e.hi] == A[e.lo]) // T is A[lo] if the run is all duplicates
+                    res = (A[e.lo] == T) ? e.lo : -1;
+                else
+                {
+                    e.pos = e.lo + (((double)(e.hi - e.lo) / (A[e.hi] - A[e.lo])) * (T - A[e.lo]));
+                    __builtin_prefetch(A + e.pos);
+                }
+            }
+            else
+            {
+                // Stage 2: probe is in cache, narrow the range
+                if (A[e.pos] == T)
+                    res = e.pos;
+                else
+                {
+                    if (A[e.pos] < T)
+                        e.lo = e.pos + 1;
+                    else
+                        e.hi = e.pos - 1;
+                    e.pos = -1;
+                    __builtin_prefetch(A + e.lo);
+                    __builtin_prefetch(A + e.hi);
+                }
+            }
+            if (res != -2)
+            {
+                R[e.k] = res;
+                e.k = -1;
+                busy--;
+            }
+        }
+    } while (busy > 0 || next < m);
+}
+
+template <class Key>
+typename std::enable_if<!std::is_arithmetic<Key>::value>::type
+InterpolationSearchBatch(const Key A[], int n, const Key K[], int m, int R[])
+{
+    BinarySearchBatch(A, n, K, m, R);
+}
+
+/* 9. EytzingerSearch
+ * The Eytzinger layout stores the sorted keys in breadth-first order of the
+ * implicit binary search tree: the root at B[1] and the children of B[k] at
+ * B[2k] and B[2k+1]. The first probes of every search then share a few hot
+ * lines, and the four levels below node k sit in one line at B[16k], which
+ * is prefetched while the next four comparisons run. The loop is branchless;
+ * the final right turns are undone with one bit scan to reach the lower
+ * bound, and I[] maps it back to its index in the sorted array.
+ * O(log n), Space: O(n) for B and I.
+ */
+template <class Key>
+int eytzinger(const Key A[], int n, Key B[], int I[], int i, long k)
+{
+    if (k <= n)
+    {
+        i = eytzinger(A, n, B, I, i, 2 * k);
+        B[k] = A[i];
+        I[k] = i++;
+        i = eytzinger(A, n, B, I, i, 2 * k + 1);
+    }
+    return i;
+}
+
+template <class Key>
+void BuildEytzinger(const Key A[], int n, Key *&B, int *&I)
+{
+    // Line aligned, so B[16k..16k+15] share a line (for int keys)
+    size_t bytes = ((n + 1) * sizeof(Key) + 63) / 64 * 64;
+    B = (Key *)aligned_alloc(64, bytes);
+    I = (int *)aligned_alloc(64, ((n + 1) * sizeof(int) + 63) / 64 * 64);
+    if (B == NULL || I == NULL)
+        throw std::bad_alloc();
+    eytzinger(A, n, B, I, 0, 1);
+}
+
+/* Slot of the first key >= T, 0 if none */
+template <class Key, class Less>
+inline long eytzingerSlot(const Key B[], int n, const Key &T, Less lt)
+{
+    const long lineKeys = 64 / sizeof(Key) ? 64 / sizeof(Key) : 1;
+    long k = 1;
+    while (k <= n)
+    {
+        __builtin_prefetch(B + k * lineKeys);
+        k = 2 * k + lt(B[k], T);
+    }
+    return k >> __builtin_ffsl(~k);
+}
+
+template <class Key, class Less = std::less<Key>>
+int EytzingerSearch(const Key B[], const int I[], int n, const Key &T, Less lt = Less())
+{
+    long k = eytzingerSlot(B, n, T, lt);
+    return (k != 0 && keyEq(B[k], T, lt)) ? I[k] : -1;
+}
+
+/* Index in the sorted array of the first key >= T, n if none */
+template <class Key, class Less = std::less<Key>>
+long EytzingerLowerBound(const Key B[], const int I[], int n, const Key &T, Less lt = Less())
+{
+    long k = eytzingerSlot(B, n, T, lt);
+    return k != 0 ? I[k] : n;
+}
+
+/* 15. Bounds and ranges
+ * The searches above return whichever matching index they reach first, or
+ * -1. With duplicates the useful answers are positions:
+ *   LowerBound(T)      first index with !(A[i] < T)
+ *   UpperBound(T)      first index with T < A[i]
+ *   EqualRange(T)      [LowerBound(T), UpperBound(T)), the copies of T
+ *   RangeCount(lo, hi) keys in [lo, hi] = UpperBound(hi) - LowerBound(lo)
+ * Branchless halving, O(log n) whatever the number of duplicates.
+ */
+template <class Key, class Less = std::less<Key>>
+long LowerBound(const Key A[], long n, const Key &T, Less lt = Less())
+{
+    if (n == 0)
+        return 0;
+    const Key *base = A;
+    for (long len = n; len > 1;)
+    {
+        long half = len / 2;
+        base += lt(base[half - 1], T) ? half : 0;
+        len -= half;
+    }
+    return (base - A) + lt(*base, T);
+}
+
+template <class Key, class Less = std::less<Key>>
+long UpperBound(const Key A[], long n, const Key &T, Less lt = Less())
+{
+    if (n == 0)
+        return 0;
+    const Key *base = A;
+    for (long len = n; len > 1;)
+    {
+        long half = len / 2;
+        base += !lt(T, base[half - 1]) ? half : 0;
+        len -= half;
+    }
+    return (base - A) + !lt(T, *base);
+}
+
+template <class Key, class Less = std::less<Key>>
+std::pair<long, long> EqualRange(const Key A[], long n, const Key &T, Less lt = Less())
+{
+    return std::make_pair(LowerBound(A, n, T, lt), UpperBound(A, n, T, lt));
+}
+
+template <class Key, class Less = std::less<Key>>
+long RangeCount(const Key A[], long n, const Key &lo, const Key &hi, Less lt = Less())
+{
+    return lt(hi, lo) ? 0 : UpperBound(A, n, hi, lt) - LowerBound(A, n, lo, lt);
+}
+
+#endif
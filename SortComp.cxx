@@ -9,7 +9,13 @@
 #include <iomanip>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -251,10 +257,7 @@ void mergeSort(int *arr, int low, int high)
 void bucketSort(int *arr, int n, int max)
 {
     int i, j;
-    int buckets[max];
-
-    // Initiate all values to 0 in buckets
-    memset(buckets, 0, max * sizeof(int));
+    vector<int> buckets(max, 0); // On the heap: max can be far past the stack
 
     // 1. counting
     for (i = 0; i < n; i++)
@@ -268,14 +271,853 @@ void bucketSort(int *arr, int n, int max)
     }
 }
 
+/* 9.
+ * radixSortLSD() - Non-Comparision Sort algorithm, distribution sorting
+ * Least significant digit first with BITS-bit digits (8, 11 or 16), so 4, 3
+ * or 2 stable scatter passes between arr and one scratch array. The counts
+ * of every digit are taken in a single read of the input, and a pass whose
+ * digit is the same for all keys is skipped. With COMBINE each bucket
+ * collects keys in a cache-line write-combining buffer and writes them out
+ * a whole aligned line at a time, instead of one int per line; it pays off
+ * where the core has fewer line fill buffers than there are buckets, and
+ * is slower on parts that cope with 2^BITS open write streams themselves.
+ * O(n*32/BITS), O(n + 2^BITS), Stable
+ */
+const int WC_INTS = 16; // Ints per write-combining buffer, one cache line
+
+static inline unsigned radixKey(int x) // Signed order as unsigned order
+{
+    return (unsigned)x ^ 0x80000000u;
+}
+
+template <int BITS, bool COMBINE = false>
+void radixSortLSD(int *arr, int n)
+{
+    const int RADIX = 1 << BITS, MASK = RADIX - 1, PASSES = (32 + BITS - 1) / BITS;
+    if (n < 2)
+        return;
+
+    // 1. counting, all digits at once
+    vector<int> hist(PASSES * RADIX, 0);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned k = radixKey(arr[i]);
+        for (int p = 0; p < PASSES; p++)
+            hist[p * RADIX + ((k >> (p * BITS)) & MASK)]++;
+    }
+
+    // 2. scattering, one digit per pass
+    int *buf = (int *)aligned_alloc(64, ((size_t)n * sizeof(int) + 63) / 64 * 64);
+    int *wc = (int *)aligned_alloc(64, COMBINE ? RADIX * WC_INTS * sizeof(int) : 64);
+    if (buf == NULL || wc == NULL)
+        throw bad_alloc();
+    vector<int> pos(RADIX), fill(RADIX), room(RADIX);
+    int *src = arr, *dst = buf;
+    for (int p = 0; p < PASSES; p++)
+    {
+        int shift = p * BITS, *h = &hist[p * RADIX];
+        if (h[(radixKey(src[0]) >> shift) & MASK] == n)
+            continue;
+        for (int d = 0, sum = 0; d < RADIX; d++)
+        {
+            pos[d] = sum;
+            sum += h[d];
+        }
+        if (COMBINE)
+        {
+            // A buffer is flushed when it holds the rest of a line of dst:
+            // the first time up to the bucket's first line boundary, then
+            // whole aligned lines
+            for (int d = 0; d < RADIX; d++)
+            {
+                fill[d] = 0;
+                room[d] = WC_INTS - (int)(((uintptr_t)(dst + pos[d]) & 63) / sizeof(int));
+            }
+            for (int i = 0; i < n; i++)
+            {
+                int v = src[i], d = (radixKey(v) >> shift) & MASK;
+                int *w = wc + d * WC_INTS;
+                w[fill[d]++] = v;
+                if (fill[d] == room[d])
+                {
+                    if (room[d] == WC_INTS) // Fixed size copy, inlined
+                        memcpy(dst + pos[d], w, WC_INTS * sizeof(int));
+                    else
+                        copy(w, w + room[d], dst + pos[d]);
+                    pos[d] += room[d];
+                    fill[d] = 0;
+                    room[d] = WC_INTS;
+                }
+            }
+            for (int d = 0; d < RADIX; d++)
+                copy(wc + d * WC_INTS, wc + d * WC_INTS + fill[d], dst + pos[d]);
+        }
+        else
+            for (int i = 0; i < n; i++)
+                dst[pos[(radixKey(src[i]) >> shift) & MASK]++] = src[i];
+        swap(src, dst);
+    }
+    if (src != arr)
+        memcpy(arr, src, n * sizeof(int));
+    free(buf);
+    free(wc);
+}
+
+/* 10.
+ * radixSortMSD() - Non-Comparision Sort algorithm, distribution sorting
+ * Most significant 8-bit digit first and in place (American flag sort):
+ * count the digit, cycle every key straight into its bucket by swaps, then
+ * sort each bucket on the next digit. Buckets under MSD_CUTOFF keys are
+ * left to insertion sort. Needs no scratch array, for runs where a second
+ * copy of the data does not fit in memory.
+ * O(n*32/8), O(256*4) per level, Unstable
+ */
+const int MSD_CUTOFF = 64; // Smaller buckets go to insertionSort
+
+void americanFlagSort(int *arr, int n, int shift)
+{
+    if (n < MSD_CUTOFF)
+    {
+        insertionSort(arr, n);
+        return;
+    }
+    int count[256] = {0}, head[256], tail[256];
+    for (int i = 0; i < n; i++)
+        count[(radixKey(arr[i]) >> shift) & 255]++;
+    for (int d = 0, sum = 0; d < 256; d++)
+    {
+        head[d] = sum;
+        sum += count[d];
+        tail[d] = sum;
+    }
+
+    // Keys displaced from a bucket are carried along until one belongs in it
+    for (int d = 0; d < 256; d++)
+        while (head[d] < tail[d])
+        {
+            int v = arr[head[d]];
+            for (int b = (radixKey(v) >> shift) & 255; b != d; b = (radixKey(v) >> shift) & 255)
+                swap(v, arr[head[b]++]);
+            arr[head[d]++] = v;
+        }
+
+    if (shift > 0)
+        for (int d = 0, start = 0; d < 256; start += count[d++])
+            americanFlagSort(arr + start, count[d], shift - 8);
+}
+
+void radixSortMSD(int *arr, int n)
+{
+    americanFlagSort(arr, n, 24);
+}
+
+/* 11.
+ * introSort() - Comparision Sort algorithm, hybrid exchange sorting
+ * quickSort with the guards it lacks: the pivot is the median of 3, or for
+ * large ranges the ninther (median of three medians of 3), recursion only
+ * goes into the smaller side, and once 2*log2(n) levels of bad splits are
+ * used up the range is finished by heapSort. Ranges under INTRO_CUTOFF
+ * keys are left to insertionSort.
+ * O(nlog(n)) worst case, O(log(n)), Unstable
+ */
+const int INTRO_CUTOFF = 16;   // Smaller ranges go to insertionSort
+const int NINTHER_MIN = 128;   // Ranges from here on use the ninther pivot
+const int PAR_CUTOFF = 1 << 14; // Smaller ranges are not split into tasks
+
+static inline int median3(int *arr, int i, int j, int k) // Index of the median
+{
+    if (arr[i] < arr[j])
+        return arr[j] < arr[k] ? j : (arr[i] < arr[k] ? k : i);
+    return arr[i] < arr[k] ? i : (arr[j] < arr[k] ? k : j);
+}
+
+static int introDepth(int n)
+{
+    int depth = 0;
+    for (; n > 1; n >>= 1)
+        depth += 2;
+    return depth;
+}
+
+/* Hoare partition around the pivot, returns the start of the right side */
+static int introPartition(int *arr, int n)
+{
+    int m;
+    if (n >= NINTHER_MIN)
+    {
+        int e = n / 8;
+        m = median3(arr, median3(arr, 0, e, 2 * e), median3(arr, 3 * e, 4 * e, 5 * e), median3(arr, 6 * e, 7 * e, n - 1));
+    }
+    else
+        m = median3(arr, 0, n / 2, n - 1);
+    int pivot = arr[m];
+    int i = 0, j = n - 1;
+    while (i <= j)
+    {
+        while (arr[i] < pivot)
+            i++;
+        while (arr[j] > pivot)
+            j--;
+        if (i <= j)
+            swap(arr[i++], arr[j--]);
+    }
+    return i;
+}
+
+void introSort(int *arr, int n, int depth)
+{
+    while (n > INTRO_CUTOFF)
+    {
+        if (depth-- == 0)
+        {
+            heapSort(arr, n);
+            return;
+        }
+        int i = introPartition(arr, n);
+        if (i < n - i)
+        {
+            introSort(arr, i, depth);
+            arr += i;
+            n -= i;
+        }
+        else
+        {
+            introSort(arr + i, n - i, depth);
+            n = i;
+        }
+    }
+    insertionSort(arr, n);
+}
+
+void introSort(int *arr, int n)
+{
+    introSort(arr, n, introDepth(n));
+}
+
+/* 12.
+ * parallelIntroSort() - introSort on k threads with work stealing
+ * Every thread owns a deque of ranges. It partitions a range, pushes one
+ * side on the back of its deque and carries on with the other, until the
+ * range is under PAR_CUTOFF keys and gets a plain introSort. A thread
+ * takes its next range from the back of its own deque (the most recent,
+ * still in cache) and, when that is empty, steals from the front of
+ * another's (the oldest, so the largest). The sort is done when no range
+ * is pending.
+ * O(nlog(n)/k), O(n/PAR_CUTOFF) tasks, Unstable
+ */
+struct IntroTask
+{
+    int *arr;  // Range to sort
+    int n;     // Its size
+    int depth; // Bad splits left before heapSort
+};
+
+struct WorkQueue
+{
+    mutex lock;
+    deque<IntroTask> task;
+};
+
+static bool nextTask(vector<WorkQueue> &queue, int w, IntroTask &t)
+{
+    int k = queue.size();
+    for (int v = 0; v < k; v++)
+    {
+        WorkQueue &q = queue[(w + v) % k];
+        lock_guard<mutex> guard(q.lock);
+        if (q.task.empty())
+            continue;
+        if (v == 0) // Own deque: newest first
+        {
+            t = q.task.back();
+            q.task.pop_back();
+        }
+        else // Another's: steal the oldest
+        {
+            t = q.task.front();
+            q.task.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void parallelIntroSort(int *arr, int n, int k)
+{
+    k = max(1, k);
+    vector<WorkQueue> queue(k);
+    atomic<long> pending(1); // Ranges pushed and not yet sorted
+    queue[0].task.push_back({arr, n, introDepth(n)});
+
+    auto worker = [&](int w) {
+        IntroTask t;
+        while (pending.load() > 0)
+        {
+            if (!nextTask(queue, w, t))
+            {
+                this_thread::yield();
+                continue;
+            }
+            while (t.n > PAR_CUTOFF && t.depth > 0)
+            {
+                int i = introPartition(t.arr, t.n);
+                t.depth--;
+                pending++;
+                {
+                    lock_guard<mutex> guard(queue[w].lock);
+                    queue[w].task.push_back({t.arr + i, t.n - i, t.depth});
+                }
+                t.n = i;
+            }
+            introSort(t.arr, t.n, t.depth);
+            pending--;
+        }
+    };
+    vector<thread> pool;
+    for (int w = 1; w < k; w++)
+        pool.emplace_back(worker, w);
+    worker(0);
+    for (auto &th : pool)
+        th.join();
+}
+
+/* 13.
+ * pdqSort() - Comparision Sort algorithm, pattern-defeating quicksort
+ * introSort with the branches taken out of the partition loop and with
+ * patterns detected instead of suffered:
+ *  - BlockQuicksort partition: a block of PDQ_BLOCK keys on each side is
+ *    compared against the pivot first, writing the offsets of misplaced
+ *    keys into small buffers with no branch on the result; the swaps then
+ *    run over the buffers. Random data no longer mispredicts per key.
+ *  - A partition that swapped nothing hints at sorted (or reversed, after
+ *    the pivot sort) input: both sides get an insertion sort that gives up
+ *    after PDQ_PARTIAL_LIMIT moves, which finishes such input in O(n).
+ *  - A pivot equal to the key just left of the range (the previous pivot)
+ *    means many duplicates: all keys equal to it are put left in one pass
+ *    and never looked at again.
+ *  - A badly unbalanced split swaps a few keys around to break the
+ *    pattern; after log2(n) of them the range goes to heapSort.
+ * O(nlog(n)) worst case, O(n) on sorted and few-distinct input, O(log(n)),
+ * Unstable
+ *
+ * Adapted from pdqsort.h by Orson Peters (https://github.com/orlp/pdqsort).
+ * Altered from the original: specialised to int keys compared with <,
+ * iterators and comparator replaced by int pointers, and restyled for this
+ * file. The thresholds, partitions and pattern-breaking swaps follow the
+ * original. Its license:
+ *
+ *   Copyright (c) 2021 Orson Peters
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty. In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ *   Permission is granted to anyone to use this software for any purpose,
+ *   including commercial applications, and to alter it and redistribute it
+ *   freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not
+ *      claim that you wrote the original software. If you use this software
+ *      in a product, an acknowledgment in the product documentation would be
+ *      appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not
+ *      be misrepresented as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source
+ *      distribution.
+ */
+const int PDQ_INSERTION = 24;    // Smaller ranges go to insertion sort
+const int PDQ_NINTHER = 128;     // Ranges from here on use the ninther pivot
+const int PDQ_PARTIAL_LIMIT = 8; // Moves before a partial insertion sort gives up
+const int PDQ_BLOCK = 64;        // Keys compared per side before swapping
+
+static inline void sort2(int *x, int *y)
+{
+    if (*y < *x)
+        swap(*x, *y);
+}
+
+static inline void sort3(int *x, int *y, int *z)
+{
+    sort2(x, y);
+    sort2(y, z);
+    sort2(x, y);
+}
+
+/* Insertion sort of [begin, end); unguarded when begin[-1] <= every key */
+template <bool GUARDED>
+static void pdqInsertion(int *begin, int *end)
+{
+    if (begin == end)
+        return;
+    for (int *cur = begin + 1; cur != end; cur++)
+    {
+        int *sift = cur, *sift1 = cur - 1;
+        if (*sift < *sift1)
+        {
+            int tmp = *sift;
+            do
+                *sift-- = *sift1;
+            while ((!GUARDED || sift != begin) && tmp < *--sift1);
+            *sift = tmp;
+        }
+    }
+}
+
+/* Insertion sort that gives up after PDQ_PARTIAL_LIMIT moves */
+static bool pdqPartialInsertion(int *begin, int *end)
+{
+    if (begin == end)
+        return true;
+    int moved = 0;
+    for (int *cur = begin + 1; cur != end; cur++)
+    {
+        if (moved > PDQ_PARTIAL_LIMIT) // Checked before each key, so a move that ends the range still succeeds
+            return false;
+        int *sift = cur, *sift1 = cur - 1;
+        if (*sift < *sift1)
+        {
+            int tmp = *sift;
+            do
+                *sift-- = *sift1;
+            while (sift != begin && tmp < *--sift1);
+            *sift = tmp;
+            moved += cur - sift;
+        }
+    }
+    return true;
+}
+
+/* Swap num misplaced pairs; as one rotation of moves when it is safe */
+static inline void pdqSwapOffsets(int *first, int *last, unsigned char *offL, unsigned char *offR, int num, bool useSwaps)
+{
+    if (useSwaps)
+    {
+        for (int i = 0; i < num; i++)
+            swap(first[offL[i]], *(last - offR[i]));
+    }
+    else if (num > 0)
+    {
+        int *l = first + offL[0], *r = last - offR[0];
+        int tmp = *l;
+        *l = *r;
+        for (int i = 1; i < num; i++)
+        {
+            l = first + offL[i];
+            *r = *l;
+            r = last - offR[i];
+            *l = *r;
+        }
+        *r = tmp;
+    }
+}
+
+/*
+ * Partition [begin, end) around *begin: keys < pivot left of it, the rest
+ * right. Returns the pivot's final place, and whether nothing was out of
+ * place.
+ */
+static pair<int *, bool> pdqPartitionRight(int *begin, int *end)
+{
+    int pivot = *begin;
+    int *first = begin, *last = end;
+
+    // The pivot sort left sentinels on both sides for these scans
+    while (*++first < pivot)
+        ;
+    if (first - 1 == begin)
+        while (first < last && !(*--last < pivot))
+            ;
+    else
+        while (!(*--last < pivot))
+            ;
+
+    bool partitioned = first >= last;
+    if (!partitioned)
+    {
+        swap(*first, *last);
+        first++;
+
+        alignas(64) unsigned char offL[PDQ_BLOCK], offR[PDQ_BLOCK];
+        int *baseL = first, *baseR = last;
+        int numL = 0, numR = 0, startL = 0, startR = 0;
+        while (first < last)
+        {
+            // Refill whichever buffer is empty, splitting what is left
+            int unknown = last - first;
+            int splitL = numL == 0 ? (numR == 0 ? unknown / 2 : unknown) : 0;
+            int splitR = numR == 0 ? unknown - splitL : 0;
+            for (int i = 0; i < min(splitL, PDQ_BLOCK); i++)
+            {
+                offL[numL] = i;
+                numL += !(*first < pivot);
+                first++;
+            }
+            for (int i = 0; i < min(splitR, PDQ_BLOCK);)
+            {
+                offR[numR] = ++i;
+                numR += *--last < pivot;
+            }
+
+            int num = min(numL, numR);
+            pdqSwapOffsets(baseL, baseR, offL + startL, offR + startR, num, numL == numR);
+            numL -= num;
+            numR -= num;
+            startL += num;
+            startR += num;
+            if (numL == 0)
+            {
+                startL = 0;
+                baseL = first;
+            }
+            if (numR == 0)
+            {
+                startR = 0;
+                baseR = last;
+            }
+        }
+
+        // Keys still listed in a buffer go to the far end of the gap
+        if (numL)
+        {
+            while (numL--)
+                swap(baseL[offL[startL + numL]], *--last);
+            first = last;
+        }
+        if (numR)
+        {
+            while (numR--)
+                swap(*(baseR - offR[startR + numR]), *first++);
+            last = first;
+        }
+    }
+
+    int *pivotPos = first - 1;
+    *begin = *pivotPos;
+    *pivotPos = pivot;
+    return make_pair(pivotPos, partitioned);
+}
+
+/* Partition [begin, end) around *begin: keys <= pivot left, > pivot right */
+static int *pdqPartitionLeft(int *begin, int *end)
+{
+    int pivot = *begin;
+    int *first = begin, *last = end;
+    while (pivot < *--last)
+        ;
+    if (last + 1 == end)
+        while (first < last && !(pivot < *++first))
+            ;
+    else
+        while (!(pivot < *++first))
+            ;
+    while (first < last)
+    {
+        swap(*first, *last);
+        while (pivot < *--last)
+            ;
+        while (!(pivot < *++first))
+            ;
+    }
+    *begin = *last;
+    *last = pivot;
+    return last;
+}
+
+static void pdqLoop(int *begin, int *end, int badAllowed, bool leftmost)
+{
+    while (true)
+    {
+        int size = end - begin;
+        if (size < PDQ_INSERTION)
+        {
+            if (leftmost)
+                pdqInsertion<true>(begin, end);
+            else
+                pdqInsertion<false>(begin, end);
+            return;
+        }
+
+        // Pivot to *begin: median of 3, or the ninther
+        int s2 = size / 2;
+        if (size > PDQ_NINTHER)
+        {
+            sort3(begin, begin + s2, end - 1);
+            sort3(begin + 1, begin + (s2 - 1), end - 2);
+            sort3(begin + 2, begin + (s2 + 1), end - 3);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+            swap(*begin, *(begin + s2));
+        }
+        else
+            sort3(begin + s2, begin, end - 1);
+
+        // Same pivot as the range's left neighbour: skip its duplicates
+        if (!leftmost && !(*(begin - 1) < *begin))
+        {
+            begin = pdqPartitionLeft(begin, end) + 1;
+            continue;
+        }
+
+        pair<int *, bool> part = pdqPartitionRight(begin, end);
+        int *pivotPos = part.first;
+        int sizeL = pivotPos - begin, sizeR = end - (pivotPos + 1);
+        if (sizeL < size / 8 || sizeR < size / 8)
+        {
+            if (--badAllowed == 0)
+            {
+                heapSort(begin, size);
+                return;
+            }
+            // Break the pattern by moving keys near both ends of each side
+            if (sizeL >= PDQ_INSERTION)
+            {
+                swap(*begin, *(begin + sizeL / 4));
+                swap(*(pivotPos - 1), *(pivotPos - sizeL / 4));
+                if (sizeL > PDQ_NINTHER)
+                {
+                    swap(*(begin + 1), *(begin + (sizeL / 4 + 1)));
+                    swap(*(begin + 2), *(begin + (sizeL / 4 + 2)));
+                    swap(*(pivotPos - 2), *(pivotPos - (sizeL / 4 + 1)));
+                    swap(*(pivotPos - 3), *(pivotPos - (sizeL / 4 + 2)));
+                }
+            }
+            if (sizeR >= PDQ_INSERTION)
+            {
+                swap(*(pivotPos + 1), *(pivotPos + (1 + sizeR / 4)));
+                swap(*(end - 1), *(end - sizeR / 4));
+                if (sizeR > PDQ_NINTHER)
+                {
+                    swap(*(pivotPos + 2), *(pivotPos + (2 + sizeR / 4)));
+                    swap(*(pivotPos + 3), *(pivotPos + (3 + sizeR / 4)));
+                    swap(*(end - 2), *(end - (1 + sizeR / 4)));
+                    swap(*(end - 3), *(end - (2 + sizeR / 4)));
+                }
+            }
+        }
+        else if (part.second && pdqPartialInsertion(begin, pivotPos) && pdqPartialInsertion(pivotPos + 1, end))
+            return; // Nothing moved, and both sides were (nearly) sorted
+
+        // Recurse left, loop right
+        pdqLoop(begin, pivotPos, badAllowed, leftmost);
+        begin = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+void pdqSort(int *arr, int n)
+{
+    if (n > 1)
+        pdqLoop(arr, arr + n, introDepth(n) / 2, true);
+}
+
+/* 14.
+ * mergeSortBuffered() - Comparision Sort algorithm, merge sorting
+ * mergeSort without an allocation per merge: one scratch buffer of n keys
+ * is taken up front and holds a copy of arr. Each level of the recursion
+ * sorts the two halves out of one array and merges them into the other,
+ * so the two arrays trade roles level by level (ping-pong) and no merge
+ * ever copies back. Ranges under MERGE_RUN keys are insertion sorted.
+ * Stable for any Less, since a tie always takes the left run first.
+ * O(nlog(n)), O(n), Stable
+ */
+const int MERGE_RUN = 16;         // Smaller ranges go to insertion sort
+const int MERGE_BLOCK = 1 << 13;  // Keys per cache block, 32 KB of ints
+const int MERGE_PAR_MIN = 1 << 16; // Smaller merges are not split
+
+template <class Less>
+static void mergeInsertion(int *arr, int n, Less lt) // Stable
+{
+    for (int i = 1; i < n; i++)
+    {
+        int v = arr[i], j = i;
+        for (; j > 0 && lt(v, arr[j - 1]); j--)
+            arr[j] = arr[j - 1];
+        arr[j] = v;
+    }
+}
+
+/* Merge sorted A and B into out, ties from A first */
+template <class Less>
+static void mergeRuns(const int *A, int na, const int *B, int nb, int *out, Less lt)
+{
+    int i = 0, j = 0, k = 0;
+    while (i < na && j < nb)
+        out[k++] = lt(B[j], A[i]) ? B[j++] : A[i++];
+    memcpy(out + k, A + i, (na - i) * sizeof(int));
+    memcpy(out + k + na - i, B + j, (nb - j) * sizeof(int));
+}
+
+/* Both hold the same n keys on entry; leaves dst sorted, src scratch */
+template <class Less>
+static void splitMerge(int *src, int *dst, int n, Less lt)
+{
+    if (n <= MERGE_RUN)
+    {
+        mergeInsertion(dst, n, lt);
+        return;
+    }
+    int h = n / 2;
+    splitMerge(dst, src, h, lt);
+    splitMerge(dst + h, src + h, n - h, lt);
+    mergeRuns(src, h, src + h, n - h, dst, lt);
+}
+
+template <class Less = less<int>>
+void mergeSortBuffered(int *arr, int n, Less lt = Less())
+{
+    if (n < 2)
+        return;
+    int *buf = new int[n];
+    memcpy(buf, arr, n * sizeof(int));
+    splitMerge(buf, arr, n, lt);
+    delete[] buf;
+}
+
+/* 15.
+ * parallelMergeSort() - mergeSortBuffered on k threads
+ * Each thread sorts one chunk of arr. Then the sorted chunks are merged
+ * pairwise, round by round, ping-ponging between arr and the buffer. Each
+ * merge is split over all k threads by merge path: a co-rank search
+ * finds, for output position i, how many of the first i outputs come from
+ * each run, so every thread merges its own equal share of the output with
+ * no coordination. Ties still go to the left run, so it stays stable.
+ * O(nlog(n)/k), O(n), Stable
+ */
+
+/* How many of the first i outputs of merging A and B come from A */
+template <class Less>
+static int coRank(int i, const int *A, int na, const int *B, int nb, Less lt)
+{
+    int lo = max(0, i - nb), hi = min(i, na);
+    while (lo < hi)
+    {
+        int j = lo + (hi - lo) / 2;
+        if (!lt(B[i - j - 1], A[j])) // A[j] is output before B[i-j-1]
+            lo = j + 1;
+        else
+            hi = j;
+    }
+    return lo;
+}
+
+template <class Less>
+static void parallelMerge(const int *A, int na, const int *B, int nb, int *out, int k, Less lt)
+{
+    int n = na + nb;
+    k = max(1, min(k, n / MERGE_PAR_MIN));
+    auto part = [&](int t) {
+        int i0 = (int)((long)n * t / k), i1 = (int)((long)n * (t + 1) / k);
+        int a0 = coRank(i0, A, na, B, nb, lt), a1 = coRank(i1, A, na, B, nb, lt);
+        mergeRuns(A + a0, a1 - a0, B + (i0 - a0), (i1 - a1) - (i0 - a0), out + i0, lt);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < k; t++)
+        pool.emplace_back(part, t);
+    part(0);
+    for (auto &th : pool)
+        th.join();
+}
+
+template <class Less = less<int>>
+void parallelMergeSort(int *arr, int n, int k, Less lt = Less())
+{
+    if (n < 2)
+        return;
+    k = max(1, min(k, n / MERGE_RUN));
+    int *buf = new int[n];
+    vector<int> cut(k + 1);
+    for (int t = 0; t <= k; t++)
+        cut[t] = (int)((long)n * t / k);
+
+    // 1. chunks, one per thread, sorted into arr
+    vector<thread> pool;
+    for (int t = 0; t < k; t++)
+        pool.emplace_back([&, t] {
+            memcpy(buf + cut[t], arr + cut[t], (cut[t + 1] - cut[t]) * sizeof(int));
+            splitMerge(buf + cut[t], arr + cut[t], cut[t + 1] - cut[t], lt);
+        });
+    for (auto &th : pool)
+        th.join();
+
+    // 2. rounds of pairwise merges, src and dst trading places
+    int *src = arr, *dst = buf;
+    for (int w = 1; w < k; w *= 2)
+    {
+        for (int t = 0; t < k; t += 2 * w)
+        {
+            int lo = cut[t], mid = cut[min(t + w, k)], hi = cut[min(t + 2 * w, k)];
+            parallelMerge(src + lo, mid - lo, src + mid, hi - mid, dst + lo, k, lt);
+        }
+        swap(src, dst);
+    }
+    if (src != arr)
+        memcpy(arr, src, n * sizeof(int));
+    delete[] buf;
+}
+
+/* 16.
+ * mergeSortBottomUp() - Comparision Sort algorithm, merge sorting
+ * Iterative, in passes of doubling run width, and cache blocked: runs of
+ * MERGE_RUN are insertion sorted, then all passes up to MERGE_BLOCK keys
+ * are done block by block while the block sits in L1/L2, and only the
+ * passes above that stream through memory. Passes ping-pong between arr
+ * and one scratch buffer.
+ * O(nlog(n)), O(n), Stable
+ */
+template <class Less>
+static void mergePass(const int *src, int *dst, int n, int width, Less lt)
+{
+    for (int lo = 0; lo < n; lo += 2 * width)
+    {
+        int mid = min(lo + width, n), hi = min(lo + 2 * width, n);
+        mergeRuns(src + lo, mid - lo, src + mid, hi - mid, dst + lo, lt);
+    }
+}
+
+template <class Less = less<int>>
+void mergeSortBottomUp(int *arr, int n, Less lt = Less())
+{
+    if (n < 2)
+        return;
+    int *buf = new int[n];
+
+    // 1. blocks, each taken through its passes in cache, ending in arr
+    for (int lo = 0; lo < n; lo += MERGE_BLOCK)
+    {
+        int len = min(MERGE_BLOCK, n - lo);
+        for (int r = 0; r < len; r += MERGE_RUN)
+            mergeInsertion(arr + lo + r, min(MERGE_RUN, len - r), lt);
+        int *src = arr + lo, *dst = buf + lo;
+        for (int w = MERGE_RUN; w < len; w *= 2)
+        {
+            mergePass(src, dst, len, w, lt);
+            swap(src, dst);
+        }
+        if (src != arr + lo)
+            memcpy(arr + lo, src, len * sizeof(int));
+    }
+
+    // 2. passes over the whole array
+    int *src = arr, *dst = buf;
+    for (int w = MERGE_BLOCK; w < n; w *= 2)
+    {
+        mergePass(src, dst, n, w, lt);
+        swap(src, dst);
+    }
+    if (src != arr)
+        memcpy(arr, src, n * sizeof(int));
+    delete[] buf;
+}
+
 /*
  * GenRandomNumber() - Generate number randomly in rang [0, max_size].
  */
 int GenRandomNumber()
 {
-    random_device rd;                              //obtain a random number from hardware
-    mt19937 gen(rd());                             //seed the generator
-    uniform_int_distribution<> distr(0, max_size); //define the range
+    static random_device rd;                              //obtain a random number from hardware
+    static mt19937 gen(rd());                             //seed the generator once
+    static uniform_int_distribution<> distr(0, max_size); //define the range
 
     //return the rand value
     return distr(gen);
@@ -357,7 +1199,7 @@ void test()
     dispResult("6.Heap", t6 - t5, t);
 
     copyArry(a, t);
-    mergeSort(t, 0, max_size);
+    mergeSort(t, 0, max_size - 1);
     auto t7 = chrono::high_resolution_clock::now(); //get end time
     dispResult("7.Merge", t7 - t6, t);
 
@@ -366,6 +1208,61 @@ void test()
     auto t8 = chrono::high_resolution_clock::now(); //get end time
     dispResult("8.Bucket", t8 - t7, t);
 
+    copyArry(a, t);
+    radixSortLSD<8>(t, max_size);
+    auto t9 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("9.Radix LSD 8", t9 - t8, t);
+
+    copyArry(a, t);
+    radixSortLSD<11>(t, max_size);
+    auto t10 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("9.Radix LSD 11", t10 - t9, t);
+
+    copyArry(a, t);
+    radixSortLSD<11, true>(t, max_size);
+    auto t11 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("9.Radix LSD 11 WC", t11 - t10, t);
+
+    copyArry(a, t);
+    radixSortLSD<16>(t, max_size);
+    auto t12 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("9.Radix LSD 16", t12 - t11, t);
+
+    copyArry(a, t);
+    radixSortMSD(t, max_size);
+    auto t13 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("10.Radix MSD", t13 - t12, t);
+
+    copyArry(a, t);
+    introSort(t, max_size);
+    auto t14 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("11.Introsort", t14 - t13, t);
+
+    copyArry(a, t);
+    parallelIntroSort(t, max_size, thread::hardware_concurrency());
+    auto t15 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("12.Introsort par", t15 - t14, t);
+
+    copyArry(a, t);
+    pdqSort(t, max_size);
+    auto t16 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("13.Pdq", t16 - t15, t);
+
+    copyArry(a, t);
+    mergeSortBuffered(t, max_size);
+    auto t17 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("14.Merge buffered", t17 - t16, t);
+
+    copyArry(a, t);
+    parallelMergeSort(t, max_size, thread::hardware_concurrency());
+    auto t18 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("15.Merge par", t18 - t17, t);
+
+    copyArry(a, t);
+    mergeSortBottomUp(t, max_size);
+    auto t19 = chrono::high_resolution_clock::now(); //get end time
+    dispResult("16.Merge bottom-up", t19 - t18, t);
+
     auto timeElapsed = chrono::duration_cast<chrono::microseconds>(t4 - t0).count();
     auto timenow = chrono::system_clock::to_time_t(chrono::system_clock::now());
     cout << "////////////////////////////////////////////////////////" << endl;
@@ -374,6 +1271,142 @@ void test()
     cout << left << setw(20) << " Completed @ " << setw(20) << ctime(&timenow) << endl;
 }
 
+/*
+ * testScaling() - parallelIntroSort from 1 thread up to every core, next to
+ * std::sort and quickSort, on random keys and on already sorted keys.
+ */
+void testScaling()
+{
+    int cores = max(1u, thread::hardware_concurrency());
+    cout << "Introsort scaling (C++, " << cores << " cores) ..." << endl;
+    cout << left << setw(20) << "Algorithm" << setw(20) << "Random(μ)" << setw(20) << "Sorted(μ)"
+         << "Is sorted?" << endl;
+
+    vector<int> sorted(a, a + max_size);
+    sort(sorted.begin(), sorted.end());
+    auto row = [&](string name, auto sortFn) {
+        long us[2];
+        bool ok = true;
+        for (int s = 0; s < 2; s++)
+        {
+            copyArry(s == 0 ? a : sorted.data(), t);
+            auto t0 = chrono::high_resolution_clock::now();
+            sortFn(t);
+            auto t1 = chrono::high_resolution_clock::now();
+            us[s] = chrono::duration_cast<chrono::microseconds>(t1 - t0).count();
+            ok &= isSorted(t);
+        }
+        cout << left << setw(20) << name << setw(20) << us[0] << setw(20) << us[1] << ok << endl;
+    };
+
+    row("std::sort", [](int *arr) { sort(arr, arr + max_size); });
+    row("2.Quick", [](int *arr) { quickSort(arr, 0, max_size - 1); });
+    row("11.Introsort", [](int *arr) { introSort(arr, max_size); });
+    for (int k = 1;; k = min(2 * k, cores))
+    {
+        row("12.Introsort x" + to_string(k), [k](int *arr) { parallelIntroSort(arr, max_size, k); });
+        if (k == cores)
+            break;
+    }
+}
+
+/*
+ * testShapes() - pdqSort against quickSort, heapSort, introSort and
+ * std::sort on input shapes that expose pivot and pattern handling.
+ * quickSort goes quadratic, and as deep as n/2, on the organ pipe; past
+ * QUICK_ADVERSE_MAX keys it would overflow the stack, so it shows n/a.
+ */
+const int QUICK_ADVERSE_MAX = 100000; // Largest organ pipe given to quickSort
+
+void testShapes()
+{
+    const char *shapes[] = {"Random", "Sorted", "Reversed", "Few unique", "Organ pipe", "Sorted+1%"};
+    const int SHAPES = sizeof(shapes) / sizeof(shapes[0]);
+    const unsigned ADVERSE = 1 << 4; // Shapes that defeat a middle pivot
+    vector<vector<int>> input(SHAPES, vector<int>(a, a + max_size));
+    sort(input[1].begin(), input[1].end());
+    input[2].assign(input[1].rbegin(), input[1].rend());
+    for (int &x : input[3])
+        x %= 16;
+    for (int i = 0; i < max_size; i++)
+        input[4][i] = min(i, max_size - i);
+    input[5] = input[1];
+    for (int i = 0; i < max_size / 100; i++)
+        input[5][a[i] % max_size] = a[max_size - 1 - i];
+
+    cout << "Input shapes (C++, μs) ..." << endl;
+    cout << left << setw(20) << "Algorithm";
+    for (auto shape : shapes)
+        cout << setw(12) << shape;
+    cout << "Is sorted?" << endl;
+
+    auto row = [&](string name, auto sortFn, unsigned skip) {
+        bool ok = true;
+        cout << left << setw(20) << name;
+        for (int s = 0; s < SHAPES; s++)
+        {
+            if (skip & (1u << s))
+            {
+                cout << setw(12) << "n/a";
+                continue;
+            }
+            copyArry(input[s].data(), t);
+            auto t0 = chrono::high_resolution_clock::now();
+            sortFn(t);
+            auto t1 = chrono::high_resolution_clock::now();
+            cout << setw(12) << chrono::duration_cast<chrono::microseconds>(t1 - t0).count();
+            ok &= isSorted(t);
+        }
+        cout << ok << endl;
+    };
+    row("2.Quick", [](int *arr) { quickSort(arr, 0, max_size - 1); }, max_size > QUICK_ADVERSE_MAX ? ADVERSE : 0);
+    row("6.Heap", [](int *arr) { heapSort(arr, max_size); }, 0);
+    row("11.Introsort", [](int *arr) { introSort(arr, max_size); }, 0);
+    row("13.Pdq", [](int *arr) { pdqSort(arr, max_size); }, 0);
+    row("std::sort", [](int *arr) { sort(arr, arr + max_size); }, 0);
+}
+
+/*
+ * testStable() - The merge sorts on keys with many ties, compared only on
+ * their top bits while the low STABLE_BITS record the input order: a
+ * stable sort leaves the low bits ascending within every tie. Timed next
+ * to std::stable_sort on the same data; mergeSort compares whole ints, so
+ * it has no ties to keep in order and is timed in test() instead.
+ */
+const int STABLE_BITS = 22; // Input order field, so up to 4M keys
+
+void testStable()
+{
+    int cores = max(1u, thread::hardware_concurrency());
+    int n = min(max_size, 1 << STABLE_BITS);
+    vector<int> tied(n), out(n);
+    for (int i = 0; i < n; i++)
+        tied[i] = (a[i] % 256) << STABLE_BITS | i;
+    auto byKey = [](int x, int y) { return (x >> STABLE_BITS) < (y >> STABLE_BITS); };
+
+    cout << "Stable merge sorts (C++, " << n << " keys, 256 distinct) ..." << endl;
+    cout << left << setw(20) << "Algorithm" << setw(20) << "Time elapsed(μ)" << setw(20) << "Is sorted?"
+         << "Is stable?" << endl;
+    auto row = [&](string name, auto sortFn) {
+        out = tied;
+        auto t0 = chrono::high_resolution_clock::now();
+        sortFn(out.data(), n);
+        auto t1 = chrono::high_resolution_clock::now();
+        bool sorted = true, stable = true;
+        for (int i = 1; i < n; i++)
+        {
+            sorted &= !byKey(out[i], out[i - 1]);
+            stable &= byKey(out[i - 1], out[i]) || out[i - 1] < out[i];
+        }
+        cout << left << setw(20) << name << setw(20) << chrono::duration_cast<chrono::microseconds>(t1 - t0).count()
+             << setw(20) << sorted << stable << endl;
+    };
+    row("14.Merge buffered", [&](int *arr, int len) { mergeSortBuffered(arr, len, byKey); });
+    row("15.Merge par x" + to_string(cores), [&](int *arr, int len) { parallelMergeSort(arr, len, cores, byKey); });
+    row("16.Merge bottom-up", [&](int *arr, int len) { mergeSortBottomUp(arr, len, byKey); });
+    row("std::stable_sort", [&](int *arr, int len) { stable_sort(arr, arr + len, byKey); });
+}
+
 int main()
 {
     try
@@ -386,6 +1419,9 @@ int main()
 
         // Start test
         test();
+        testScaling();
+        testShapes();
+        testStable();
     }
     catch (const std::exception &e)
     {
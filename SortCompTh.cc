@@ -9,6 +9,8 @@
 #include <iomanip>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
 #include <thread>
 
@@ -18,6 +20,7 @@ int max_size; // Size of data dictionary
 
 int *a;                                     // Data dictionary
 int *d0, *d1, *d2, *d3, *d4, *d5, *d6, *d7; // Temp data dictionary
+int *d8, *d9, *d10, *d11;
 
 /*
  * Verify if the array was sorted.
@@ -252,9 +255,7 @@ void mergeSort(int arr[], int low, int high)
 void bucketSort(int *arr, int n, int max)
 {
     int i, j;
-    int buckets[max];
-
-    memset(buckets, 0, max * sizeof(int));
+    vector<int> buckets(max, 0); // On the heap: max can be far past the stack
 
     for (i = 0; i < n; i++)
         buckets[arr[i]]++;
@@ -266,14 +267,224 @@ void bucketSort(int *arr, int n, int max)
     }
 }
 
+/* 9.
+ * radixSortLSD() - Non-Comparision Sort algorithm, distribution sorting
+ * Least significant digit first with BITS-bit digits (8, 11 or 16), so 4, 3
+ * or 2 stable scatter passes between arr and one scratch array. The counts
+ * of every digit are taken in a single read of the input, and a pass whose
+ * digit is the same for all keys is skipped. With COMBINE each bucket
+ * collects keys in a cache-line write-combining buffer and writes them out
+ * a whole aligned line at a time, instead of one int per line; it pays off
+ * where the core has fewer line fill buffers than there are buckets, and
+ * is slower on parts that cope with 2^BITS open write streams themselves.
+ * O(n*32/BITS), O(n + 2^BITS), Stable
+ */
+const int WC_INTS = 16; // Ints per write-combining buffer, one cache line
+
+static inline unsigned radixKey(int x) // Signed order as unsigned order
+{
+    return (unsigned)x ^ 0x80000000u;
+}
+
+template <int BITS, bool COMBINE = false>
+void radixSortLSD(int *arr, int n)
+{
+    const int RADIX = 1 << BITS, MASK = RADIX - 1, PASSES = (32 + BITS - 1) / BITS;
+    if (n < 2)
+        return;
+
+    // 1. counting, all digits at once
+    vector<int> hist(PASSES * RADIX, 0);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned k = radixKey(arr[i]);
+        for (int p = 0; p < PASSES; p++)
+            hist[p * RADIX + ((k >> (p * BITS)) & MASK)]++;
+    }
+
+    // 2. scattering, one digit per pass
+    int *buf = (int *)aligned_alloc(64, ((size_t)n * sizeof(int) + 63) / 64 * 64);
+    int *wc = (int *)aligned_alloc(64, COMBINE ? RADIX * WC_INTS * sizeof(int) : 64);
+    if (buf == NULL || wc == NULL)
+        throw bad_alloc();
+    vector<int> pos(RADIX), fill(RADIX), room(RADIX);
+    int *src = arr, *dst = buf;
+    for (int p = 0; p < PASSES; p++)
+    {
+        int shift = p * BITS, *h = &hist[p * RADIX];
+        if (h[(radixKey(src[0]) >> shift) & MASK] == n)
+            continue;
+        for (int d = 0, sum = 0; d < RADIX; d++)
+        {
+            pos[d] = sum;
+            sum += h[d];
+        }
+        if (COMBINE)
+        {
+            // A buffer is flushed when it holds the rest of a line of dst:
+            // the first time up to the bucket's first line boundary, then
+            // whole aligned lines
+            for (int d = 0; d < RADIX; d++)
+            {
+                fill[d] = 0;
+                room[d] = WC_INTS - (int)(((uintptr_t)(dst + pos[d]) & 63) / sizeof(int));
+            }
+            for (int i = 0; i < n; i++)
+            {
+                int v = src[i], d = (radixKey(v) >> shift) & MASK;
+                int *w = wc + d * WC_INTS;
+                w[fill[d]++] = v;
+                if (fill[d] == room[d])
+                {
+                    if (room[d] == WC_INTS) // Fixed size copy, inlined
+                        memcpy(dst + pos[d], w, WC_INTS * sizeof(int));
+                    else
+                        copy(w, w + room[d], dst + pos[d]);
+                    pos[d] += room[d];
+                    fill[d] = 0;
+                    room[d] = WC_INTS;
+                }
+            }
+            for (int d = 0; d < RADIX; d++)
+                copy(wc + d * WC_INTS, wc + d * WC_INTS + fill[d], dst + pos[d]);
+        }
+        else
+            for (int i = 0; i < n; i++)
+                dst[pos[(radixKey(src[i]) >> shift) & MASK]++] = src[i];
+        swap(src, dst);
+    }
+    if (src != arr)
+        memcpy(arr, src, n * sizeof(int));
+    free(buf);
+    free(wc);
+}
+
+/* 10.
+ * radixSortMSD() - Non-Comparision Sort algorithm, distribution sorting
+ * Most significant 8-bit digit first and in place (American flag sort):
+ * count the digit, cycle every key straight into its bucket by swaps, then
+ * sort each bucket on the next digit. Buckets under MSD_CUTOFF keys are
+ * left to insertion sort. Needs no scratch array, for runs where a second
+ * copy of the data does not fit in memory.
+ * O(n*32/8), O(256*4) per level, Unstable
+ */
+const int MSD_CUTOFF = 64; // Smaller buckets go to insertionSort
+
+void americanFlagSort(int *arr, int n, int shift)
+{
+    if (n < MSD_CUTOFF)
+    {
+        insertionSort(arr, n);
+        return;
+    }
+    int count[256] = {0}, head[256], tail[256];
+    for (int i = 0; i < n; i++)
+        count[(radixKey(arr[i]) >> shift) & 255]++;
+    for (int d = 0, sum = 0; d < 256; d++)
+    {
+        head[d] = sum;
+        sum += count[d];
+        tail[d] = sum;
+    }
+
+    // Keys displaced from a bucket are carried along until one belongs in it
+    for (int d = 0; d < 256; d++)
+        while (head[d] < tail[d])
+        {
+            int v = arr[head[d]];
+            for (int b = (radixKey(v) >> shift) & 255; b != d; b = (radixKey(v) >> shift) & 255)
+                swap(v, arr[head[b]++]);
+            arr[head[d]++] = v;
+        }
+
+    if (shift > 0)
+        for (int d = 0, start = 0; d < 256; start += count[d++])
+            americanFlagSort(arr + start, count[d], shift - 8);
+}
+
+void radixSortMSD(int *arr, int n)
+{
+    americanFlagSort(arr, n, 24);
+}
+
+/* 11.
+ * parallelRadixSort() - Non-Comparision Sort algorithm, distribution sorting
+ * LSD radix sort of 11-bit digits on k threads. arr is cut into k chunks;
+ * each pass every thread counts the digits of its chunk, the counts are
+ * merged by a prefix sum in (digit, thread) order, which hands each thread
+ * its own disjoint range inside every bucket, and then all threads scatter
+ * their chunks at once with no locking. Stable, like radixSortLSD.
+ * O(3n/k), O(n + k*2^11), Stable
+ */
+void parallelRadixSort(int *arr, int n, int k)
+{
+    const int BITS = 11, RADIX = 1 << BITS, MASK = RADIX - 1, PASSES = 3;
+    if (n < 2)
+        return;
+    k = max(1, min(k, n));
+    int *buf = new int[n];
+    vector<vector<int>> hist(k, vector<int>(RADIX));
+    auto chunk = [&](int t) { return (int)((long)n * t / k); };
+
+    int *src = arr, *dst = buf;
+    for (int p = 0; p < PASSES; p++)
+    {
+        int shift = p * BITS;
+
+        // 1. counting, per thread
+        vector<thread> pool;
+        for (int t = 0; t < k; t++)
+            pool.emplace_back([&, t] {
+                vector<int> &h = hist[t];
+                fill(h.begin(), h.end(), 0);
+                for (int i = chunk(t); i < chunk(t + 1); i++)
+                    h[(radixKey(src[i]) >> shift) & MASK]++;
+            });
+        for (auto &th : pool)
+            th.join();
+
+        // 2. prefix sum: thread t writes bucket d after threads < t
+        int sum = 0;
+        bool trivial = false;
+        for (int d = 0; d < RADIX; d++)
+        {
+            int start = sum;
+            for (int t = 0; t < k; t++)
+            {
+                int c = hist[t][d];
+                hist[t][d] = sum;
+                sum += c;
+            }
+            trivial |= sum - start == n;
+        }
+        if (trivial) // Every key has the same digit
+            continue;
+
+        // 3. scattering, per thread into its own ranges
+        pool.clear();
+        for (int t = 0; t < k; t++)
+            pool.emplace_back([&, t] {
+                vector<int> &pos = hist[t];
+                for (int i = chunk(t); i < chunk(t + 1); i++)
+                    dst[pos[(radixKey(src[i]) >> shift) & MASK]++] = src[i];
+            });
+        for (auto &th : pool)
+            th.join();
+        swap(src, dst);
+    }
+    if (src != arr)
+        memcpy(arr, src, n * sizeof(int));
+    delete[] buf;
+}
+
 /*
  * GenRandomNumber() - Generate number randomly in rang [0, max_size].
  */
 int GenRandomNumber()
 {
-    random_device rd;                              //obtain a random number from hardware
-    mt19937 gen(rd());                             //seed the generator
-    uniform_int_distribution<> distr(0, max_size); //define the range
+    static random_device rd;                              //obtain a random number from hardware
+    static mt19937 gen(rd());                             //seed the generator once
+    static uniform_int_distribution<> distr(0, max_size); //define the range
 
     //return the rand value
     return distr(gen);
@@ -312,6 +523,10 @@ void BuildDataDictionary()
     d5 = new int[max_size];
     d6 = new int[max_size];
     d7 = new int[max_size];
+    d8 = new int[max_size];
+    d9 = new int[max_size];
+    d10 = new int[max_size];
+    d11 = new int[max_size];
 
     // Assign values to array
     for (int i = 0; i < max_size; i++)
@@ -339,6 +554,10 @@ void test()
     thread cp_t5(copyArry, a, d5);
     thread cp_t6(copyArry, a, d6);
     thread cp_t7(copyArry, a, d7);
+    thread cp_t8(copyArry, a, d8);
+    thread cp_t9(copyArry, a, d9);
+    thread cp_t10(copyArry, a, d10);
+    thread cp_t11(copyArry, a, d11);
     cp_t0.join();
     cp_t1.join();
     cp_t2.join();
@@ -347,17 +566,25 @@ void test()
     cp_t5.join();
     cp_t6.join();
     cp_t7.join();
+    cp_t8.join();
+    cp_t9.join();
+    cp_t10.join();
+    cp_t11.join();
 
     /** start the array sort threads */
     auto t0 = chrono::high_resolution_clock::now(); //get start time
     thread st_t0(bubbleSort, d0, max_size);
-    thread st_t1(quickSort, d1, 0, max_size);
+    thread st_t1(quickSort, d1, 0, max_size - 1);
     thread st_t2(insertionSort, d2, max_size);
     thread st_t3(shellSort, d3, max_size);
     thread st_t4(selectionSort, d4, max_size);
     thread st_t5(heapSort, d5, max_size);
-    thread st_t6(mergeSort, d6, 0, max_size);
+    thread st_t6(mergeSort, d6, 0, max_size - 1);
     thread st_t7(bucketSort, d7, max_size, max_size + 1);
+    thread st_t8(radixSortLSD<8>, d8, max_size);
+    thread st_t9(radixSortLSD<11>, d9, max_size);
+    thread st_t10(radixSortLSD<16>, d10, max_size);
+    thread st_t11(radixSortMSD, d11, max_size);
     st_t0.join();   auto t1 = chrono::high_resolution_clock::now(); //get start time
     dispResult("1.Bubble", t1 - t0, d0);
     st_t1.join();   auto t2 = chrono::high_resolution_clock::now(); //get start time
@@ -374,6 +601,14 @@ void test()
     dispResult("7.Merge", t7 - t6, d6);
     st_t7.join();   auto t8 = chrono::high_resolution_clock::now(); //get start time
     dispResult("8.Bucket", t8 - t7, d7);
+    st_t8.join();   auto t9 = chrono::high_resolution_clock::now(); //get start time
+    dispResult("9.Radix LSD 8", t9 - t8, d8);
+    st_t9.join();   auto t10 = chrono::high_resolution_clock::now(); //get start time
+    dispResult("9.Radix LSD 11", t10 - t9, d9);
+    st_t10.join();  auto t11 = chrono::high_resolution_clock::now(); //get start time
+    dispResult("9.Radix LSD 16", t11 - t10, d10);
+    st_t11.join();  auto t12 = chrono::high_resolution_clock::now(); //get start time
+    dispResult("10.Radix MSD", t12 - t11, d11);
     
     auto t = chrono::high_resolution_clock::now(); //get end time
 
@@ -386,6 +621,36 @@ void test()
     cout << left << setw(20) << " Completed @ " << setw(20) << ctime(&timenow) << endl;
 }
 
+/*
+ * testParallel() - Speedup curve of parallelRadixSort from 1 thread up to
+ * every core, against its own 1 thread time.
+ */
+void testParallel()
+{
+    int cores = max(1u, thread::hardware_concurrency());
+    vector<int> ks;
+    for (int k = 1; k < cores; k *= 2)
+        ks.push_back(k);
+    ks.push_back(cores);
+
+    cout << "Parallel radix sort (C++, " << cores << " cores) ..." << endl;
+    cout << left << setw(20) << "Threads" << setw(20) << "Time elapsed(μ)" << setw(20) << "Speedup" << setw(20) << "GB/s"
+         << "Is sorted?" << endl;
+    double base = 0;
+    for (int k : ks)
+    {
+        copyArry(a, d0);
+        auto t0 = chrono::high_resolution_clock::now();
+        parallelRadixSort(d0, max_size, k);
+        auto t1 = chrono::high_resolution_clock::now();
+        double us = chrono::duration<double, micro>(t1 - t0).count();
+        if (k == 1)
+            base = us;
+        cout << left << setw(20) << k << setw(20) << (long)us << setw(20) << base / us << setw(20)
+             << (double)max_size * sizeof(int) / us / 1000 << isSorted(d0) << endl;
+    }
+}
+
 int main()
 {
 
@@ -399,6 +664,7 @@ int main()
 
         // Start test
         test();
+        testParallel();
     }
     catch (const std::exception &e)
     {
@@ -414,5 +680,9 @@ int main()
     delete[] d5;
     delete[] d6;
     delete[] d7;
+    delete[] d8;
+    delete[] d9;
+    delete[] d10;
+    delete[] d11;
     return 0;
 }
\ No newline at end of file